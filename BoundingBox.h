@@ -0,0 +1,119 @@
+#ifndef TRAINS_BOUNDING_BOX_H
+#define TRAINS_BOUNDING_BOX_H
+
+#include <maths/Vector.h>
+
+#include <algorithm>
+#include <limits>
+
+// Axis aligned bounding box, which is empty until a point is included
+template <int N, typename T>
+class BoundingBox
+{
+public:
+    typedef maths::Vector<N, T> VecN;
+
+private:
+    VecN minCorner;
+    VecN maxCorner;
+
+public:
+    BoundingBox()
+    : minCorner(std::numeric_limits<T>::max()),
+      maxCorner(std::numeric_limits<T>::lowest())
+    {
+    }
+
+    BoundingBox(const VecN &a, const VecN &b)
+    : BoundingBox()
+    {
+        include(a);
+        include(b);
+    }
+
+    // Accessors
+    const VecN &getMin() const
+    {
+        return minCorner;
+    }
+    const VecN &getMax() const
+    {
+        return maxCorner;
+    }
+    bool empty() const
+    {
+        return minCorner[0] > maxCorner[0];
+    }
+
+    // Grow to include a point or another box
+    void include(const VecN &point)
+    {
+        for (int i = 0; i < N; ++i) {
+            minCorner[i] = std::min(minCorner[i], point[i]);
+            maxCorner[i] = std::max(maxCorner[i], point[i]);
+        }
+    }
+    void include(const BoundingBox &other)
+    {
+        if (other.empty())
+            return;
+        include(other.minCorner);
+        include(other.maxCorner);
+    }
+
+    // Grow by distance in every direction
+    void expand(T distance)
+    {
+        if (empty())
+            return;
+        for (int i = 0; i < N; ++i) {
+            minCorner[i] -= distance;
+            maxCorner[i] += distance;
+        }
+    }
+
+    bool contains(const VecN &point) const
+    {
+        for (int i = 0; i < N; ++i)
+            if (point[i] < minCorner[i] || point[i] > maxCorner[i])
+                return false;
+        return true;
+    }
+    bool contains(const BoundingBox &other) const
+    {
+        for (int i = 0; i < N; ++i)
+            if (other.minCorner[i] < minCorner[i] || other.maxCorner[i] > maxCorner[i])
+                return false;
+        return true;
+    }
+    bool intersects(const BoundingBox &other) const
+    {
+        for (int i = 0; i < N; ++i)
+            if (other.maxCorner[i] < minCorner[i] || other.minCorner[i] > maxCorner[i])
+                return false;
+        return true;
+    }
+
+    // Square of the distance from a point outside, or 0 inside
+    T distanceSqr(const VecN &point) const
+    {
+        T total = 0;
+        for (int i = 0; i < N; ++i) {
+            T outside = std::max(std::max(minCorner[i] - point[i], point[i] - maxCorner[i]), (T)0);
+            total += outside * outside;
+        }
+        return total;
+    }
+    // Sum of the side lengths, a cheap measure of size for building trees
+    T sideSum() const
+    {
+        T total = 0;
+        for (int i = 0; i < N; ++i)
+            total += maxCorner[i] - minCorner[i];
+        return total;
+    }
+};
+
+typedef BoundingBox<2, float> Box2f;
+
+#endif // TRAINS_BOUNDING_BOX_H
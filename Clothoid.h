@@ -4,11 +4,15 @@
 #include <maths/Vector.h>
 #include <maths/Matrix.h>
 
+#include <BoundingBox.h>
 #include <Fresnel.h>
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 
-template <typename L, typename C>
+// F is the policy for evaluating Fresnel integrals, see Fresnel.h
+template <typename L, typename C, typename F = FresnelExact>
 class Clothoid
 {
 public:
@@ -45,6 +49,17 @@ public:
     {
     }
 
+    // Copy the shape of a clothoid with a different Fresnel policy
+    template <typename G>
+    explicit Clothoid(const Clothoid<L, C, G> &other)
+    : startPosition(other.getStartPosition()),
+      startDirection(other.getStartDirection()),
+      startCurvature(other.getStartCurvature()),
+      length(other.getLength())
+    {
+        setCurvatureRate(other.getCurvatureRate());
+    }
+
     // Setters
     void setStartPosition(const Vec2l &newStartPosition)
     {
@@ -110,19 +125,23 @@ public:
     {
         return length;
     }
+    // Find the length of a parallel line. Each element of the parallel is
+    // scaled by (1 - leftOffset * curvature), which is linear along the
+    // clothoid, so this is exact while leftOffset is within the radius of
+    // curvature.
     Length getParallelLength(Length leftOffset) const
     {
-        if (!leftOffset)
-            return length;
-        if (curvatureRate != 0) {
-            float avgCurvature = (startCurvature + getEndCurvature()) / 2;
-            // FIXME calculate correctly
-            return length * ((Length)1 - leftOffset * avgCurvature);
-        } else if (startCurvature != 0) {
-            return length * ((Length)1 - leftOffset * startCurvature);
-        } else {
-            return length;
-        }
+        return length - leftOffset * getEndDirectionChange();
+    }
+    // Find the length along the clothoid at parallelLength along a parallel
+    // line, inverting the quadratic parallel length at a given length
+    Length lengthAtParallelLength(Length leftOffset, Length parallelLength) const
+    {
+        // parallelLength = b*length + a*length², taking the stable root
+        Length a = -leftOffset * curvatureRate / 2;
+        Length b = (Length)1 - leftOffset * startCurvature;
+        Length discriminant = std::max(b * b + 4 * a * parallelLength, (Length)0);
+        return 2 * parallelLength / (b + sqrt(discriminant));
     }
 
     // Find information about the end
@@ -206,10 +225,10 @@ public:
             // Length from zero curvature
             Length lengthOffs = -lengthAtCurvature(0);
             // 2D fresnel offset from zero curvature
-            Vec2l fresOffs = fresnel(lengthOffs * fresnelScale);
+            Vec2l fresOffs = F::calc(lengthOffs * fresnelScale);
 
             // Calculate 2D fresnel for offset & scaled length
-            fres = (fresnel((length + lengthOffs) * fresnelScale) - fresOffs) / fresnelScale;
+            fres = (F::calc((length + lengthOffs) * fresnelScale) - fresOffs) / fresnelScale;
             fresRotation = fresnelDirection(lengthOffs * fresnelScale);
 
             // Compensate for negative change in curvature
@@ -242,22 +261,115 @@ public:
         return startPosition + matrix * fres;
     }
 
-    Vec2f parallelPositionAtLength(Length leftOffset, Length length) const
+    // Find the 2D positions at each of count distances
+    void positionsAtLengths(const Length *lengths, Vec2l *outPositions,
+                            size_t count) const
     {
-        Vec2f position = positionAtLength(length);
+        if (curvatureRate == 0) {
+            for (size_t i = 0; i < count; ++i)
+                outPositions[i] = positionAtLength(lengths[i]);
+            return;
+        }
+
+        // As positionAtLength(), but the offset and rotation are only
+        // calculated once, and the fresnel integrals are batched
+        constexpr Length invSqrt2 = (Length)1/sqrt(2);
+        const Length fresnelScale = curvatureRateSqrt / invSqrt2 / 2;
+        const Length invFresnelScale = (Length)1 / fresnelScale;
+        Length lengthOffs = -lengthAtCurvature(0);
+        Vec2l fresOffs = F::calc(lengthOffs * fresnelScale);
+        Angle fresRotation = fresnelDirection(lengthOffs * fresnelScale);
+        Length flip = 1;
+        if (curvatureRate < 0) {
+            flip = -1;
+            fresRotation = -fresRotation;
+        }
+
+        Angle rotation = startDirection - fresRotation;
+        Mat22l matrix;
+        maths::sincos((Length)rotation, &matrix[0][1], &matrix[0][0]);
+        matrix[1][0] = -matrix[0][1];
+        matrix[1][1] = matrix[0][0];
+
+        // Work in chunks so the arguments fit on the stack
+        constexpr size_t chunkSize = 64;
+        Length args[chunkSize];
+        for (size_t i = 0; i < count; i += chunkSize) {
+            size_t n = std::min(chunkSize, count - i);
+            for (size_t j = 0; j < n; ++j)
+                args[j] = (lengths[i + j] + lengthOffs) * fresnelScale;
+            Vec2l *out = outPositions + i;
+            F::calcBatch(args, out, n);
+            for (size_t j = 0; j < n; ++j) {
+                Vec2l fres = (out[j] - fresOffs) * invFresnelScale;
+                fres[1] *= flip;
+                out[j] = startPosition + matrix * fres;
+            }
+        }
+    }
+
+    // Sample count points at uniform distances start + step*i, outputting
+    // positions, and optionally unit direction vectors and curvatures.
+    // Rather than evaluating Fresnel integrals and trig functions for every
+    // sample, the direction is advanced by a rotation recurrence (the change
+    // in direction per step changes by a constant rotation), and position by
+    // Simpson's rule over each step. Every sampleAnchorInterval samples the
+    // exact position and direction are recalculated, bounding drift, so the
+    // results are about as accurate as calling positionAtLength() for each.
+    static constexpr size_t sampleAnchorInterval = 64;
+    void sampleUniform(Length start, Length step, size_t count,
+                       Vec2l *outPositions, Vec2l *outDirections = nullptr,
+                       Curvature *outCurvatures = nullptr) const
+    {
+        const Length halfStep = step / 2;
+        // Rotations are stored minus one (i.e. cos - 1, sin) to preserve
+        // precision, as they are all close to the identity.
+        // Rotation of the direction over the next half step
+        Vec2l rotation;
+        // Constant change in that rotation per half step
+        const Vec2l rotationDelta = rotationMinusOne(curvatureRate * halfStep * halfStep);
+
+        // Position is accumulated relative to the last anchor for precision
+        Vec2l anchor, offset, direction;
+        for (size_t i = 0; i < count; ++i) {
+            Length len = start + step * i;
+            if (i % sampleAnchorInterval == 0) {
+                anchor = positionAtLength(len);
+                offset = Vec2l((Length)0);
+                maths::sincos((Length)directionAtLength(len), &direction[1], &direction[0]);
+                rotation = rotationMinusOne(halfStep * (curvatureAtLength(len) +
+                                                        curvatureRate * halfStep / 2));
+            } else {
+                Vec2l midDirection = direction + complexMultiply(direction, rotation);
+                rotation += rotationDelta + complexMultiply(rotation, rotationDelta);
+                Vec2l endDirection = midDirection + complexMultiply(midDirection, rotation);
+                rotation += rotationDelta + complexMultiply(rotation, rotationDelta);
+                offset += (direction + midDirection * (Length)4 + endDirection) * (step / 6);
+                direction = endDirection;
+            }
+
+            outPositions[i] = anchor + offset;
+            if (outDirections)
+                outDirections[i] = direction;
+            if (outCurvatures)
+                outCurvatures[i] = curvatureAtLength(len);
+        }
+    }
+
+    Vec2l parallelPositionAtLength(Length leftOffset, Length length) const
+    {
+        Vec2l position = positionAtLength(length);
         Angle direction = directionAtLength(length);
         Vec2l leftVec;
         maths::sincos((Length)(direction + M_PI/2), &leftVec[1], &leftVec[0]);
         return position + leftVec * leftOffset;
     }
 
-    Vec2f parallelPositionAtParallelLength(Length leftOffset, Length parallelDistance,
+    Vec2l parallelPositionAtParallelLength(Length leftOffset, Length parallelDistance,
                                            Mat22l *outRotMatrix = nullptr) const
     {
-        // FIXME this isn't quite accurate for variable curvature
-        float totalParallelLength = getParallelLength(leftOffset);
-        float midLength = length * parallelDistance / totalParallelLength;
-        Vec2f position = positionAtLength(midLength);
+        Length midLength = lengthAtParallelLength(leftOffset, parallelDistance);
+        Vec2l position = positionAtLength(midLength);
         Angle direction = directionAtLength(midLength);
         Vec2l leftVec;
         maths::sincos((Length)(direction + M_PI/2), &leftVec[1], &leftVec[0]);
@@ -269,6 +381,99 @@ public:
         return position + leftVec * leftOffset;
     }
 
+    // Find a step from fromLength, limited to the end of the clothoid, over
+    // which the chord of a parallel line deviates from it by no more than
+    // tolerance. Over length h with curvature up to k this is at most k*h²/8.
+    // The step is negative for clothoids of negative length, which run
+    // backwards from their start.
+    Length parallelTessellationStep(Length leftOffset, Length fromLength,
+                                    Length tolerance) const
+    {
+        Length step = length - fromLength;
+        Length bound = parallelCurvatureBound(leftOffset, fromLength, fromLength);
+        if (bound * step * step > 8 * tolerance)
+            step = std::copysign(sqrt(8 * tolerance / bound), step);
+        // Curvature may be larger at the end of the step, and the bound
+        // including it also holds for any shorter step
+        bound = parallelCurvatureBound(leftOffset, fromLength, fromLength + step);
+        if (bound * step * step > 8 * tolerance)
+            step = std::copysign(sqrt(8 * tolerance / bound), step);
+        return step;
+    }
+
+    // Whether len is at or beyond the end of the clothoid, in the direction
+    // it runs from its start
+    bool isAtEnd(Length len) const
+    {
+        return length >= 0 ? len >= length : len <= length;
+    }
+
+    // Find the length between from and to of the point closest to point,
+    // assuming there is only one local minimum of distance in that range.
+    // Newton's method is used to find where the offset to point is normal
+    // to the curve, falling back to bisection if it leaves the bracket.
+    Length closestLength(const Vec2l &point, Length from, Length to,
+                         Length guess, Length tolerance) const
+    {
+        // Derivative of half the square distance, positive moving away
+        auto distanceRate = [&](Length len, Length *outRateRate) {
+            Vec2l offset = positionAtLength(len) - point;
+            Vec2l tangent;
+            maths::sincos((Length)directionAtLength(len), &tangent[1], &tangent[0]);
+            if (outRateRate) {
+                Vec2l normal(-tangent[1], tangent[0]);
+                *outRateRate = (Length)1 + curvatureAtLength(len) * (offset * normal);
+            }
+            return offset * tangent;
+        };
+
+        if (distanceRate(from, nullptr) >= 0)
+            return from;
+        if (distanceRate(to, nullptr) <= 0)
+            return to;
+        Length len = std::min(std::max(guess, from), to);
+        for (int i = 0; i < 32 && to - from > tolerance; ++i) {
+            Length rateRate;
+            Length rate = distanceRate(len, &rateRate);
+            if (rate < 0)
+                from = len;
+            else
+                to = len;
+            Length next = len - rate / rateRate;
+            if (!(rateRate > 0 && next > from && next < to))
+                next = (from + to) / 2;
+            if (fabs(next - len) < tolerance)
+                return next;
+            len = next;
+        }
+        return len;
+    }
+
+    // Find a box containing a parallel line. The line is split into steps
+    // whose chords deviate from it by no more than tolerance, and the box of
+    // each chord is expanded by its deviation bound. This relies on each step turning
+    // by less than about a radian, so tolerance should be under a tenth of
+    // the minimum radius of curvature.
+    BoundingBox<2, Length> parallelBounds(Length leftOffset, Length tolerance) const
+    {
+        BoundingBox<2, Length> bounds;
+        Length len = 0;
+        Vec2l last = parallelPositionAtLength(leftOffset, 0);
+        bounds.include(last);
+        while (!isAtEnd(len)) {
+            Length step = parallelTessellationStep(leftOffset, len, tolerance);
+            Length deviation = parallelCurvatureBound(leftOffset, len, len + step)
+                             * step * step / 8;
+            len += step;
+            Vec2l next = parallelPositionAtLength(leftOffset, len);
+            BoundingBox<2, Length> chord(last, next);
+            chord.expand(deviation);
+            bounds.include(chord);
+            last = next;
+        }
+        return bounds;
+    }
+
     // Find the distance to curvature finalCurvature
     Length lengthAtCurvature(Curvature finalCurvature) const
     {
@@ -280,6 +485,34 @@ public:
     {
         return directionAtLength(lengthAtCurvature(finalCurvature));
     }
+
+private:
+    // Bound the parallel curvature times the square of the parallel length
+    // scale between lengths from and to, in terms of the centre line length
+    Length parallelCurvatureBound(Length leftOffset, Length from, Length to) const
+    {
+        Curvature curvatureFrom = curvatureAtLength(from);
+        Curvature curvatureTo = curvatureAtLength(to);
+        Length curvature = std::max(fabs(curvatureFrom), fabs(curvatureTo));
+        Length scale = std::max(fabs((Length)1 - leftOffset * curvatureFrom),
+                                fabs((Length)1 - leftOffset * curvatureTo));
+        return curvature * scale;
+    }
+
+    // Multiply vectors a and b as complex numbers
+    static Vec2l complexMultiply(const Vec2l &a, const Vec2l &b)
+    {
+        return Vec2l(a[0] * b[0] - a[1] * b[1],
+                     a[0] * b[1] + a[1] * b[0]);
+    }
+
+    // Find (cos - 1, sin) of a small angle without cancellation
+    static Vec2l rotationMinusOne(Angle angle)
+    {
+        Length sin, cos;
+        maths::sincos((Length)(angle / 2), &sin, &cos);
+        return Vec2l(-2 * sin * sin, 2 * sin * cos);
+    }
 };
 
 #endif // TRAINS_CLOTHOID_H
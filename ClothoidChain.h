@@ -3,38 +3,123 @@
 
 #include "Clothoid.h"
 
-#include <list>
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
 
-template <typename L, typename C>
+/*
+ * A sequence of clothoids each following on from the last, stored
+ * contiguously with cumulative lengths for logarithmic time lookup.
+ * The last clothoid marks the end of the chain, and its own length is not
+ * counted, as each clothoid's shape is only final once the next is appended.
+ */
+template <typename L, typename C, typename F = FresnelExact>
 class ClothoidChain
 {
 public:
-    typedef ::Clothoid<L, C> Clothoid;
+    typedef ::Clothoid<L, C, F> Clothoid;
     typedef typename Clothoid::Length Length;
     typedef typename Clothoid::Angle Angle;
     typedef typename Clothoid::Curvature Curvature;
     typedef typename Clothoid::CurvatureRate CurvatureRate;
     typedef typename Clothoid::Vec2l Vec2l;
     typedef typename Clothoid::Mat22l Mat22l;
-    typedef std::list<Clothoid> ClothoidList;
+    typedef std::vector<Clothoid> ClothoidList;
 
 private:
     ClothoidList chain;
+    // Cumulative length and direction change at the start of each clothoid.
+    // Parallel lengths are linear in the offset, so the parallel length at
+    // any offset is startLengths[i] - leftOffset * startDirectionChanges[i].
+    std::vector<Length> startLengths;
+    std::vector<Angle> startDirectionChanges;
+    // Incremented whenever the chain changes, invalidating cursors
+    unsigned int revision;
+
+    // Coarse tessellation of each clothoid seeding projections, see project()
+    struct SeedVertex {
+        Vec2l position;
+        size_t index;
+        Length length;
+    };
+    std::vector<SeedVertex> seeds;
 
 public:
+    /*
+     * Cached location in the chain for sequential parallel length queries.
+     * Nearby queries only need to step between neighbouring clothoids, so
+     * a cursor moving gradually along the chain makes lookups amortized
+     * constant time. A cursor is reset automatically if used with a
+     * different chain, a modified chain, or a different offset.
+     */
+    class Cursor
+    {
+    private:
+        friend class ClothoidChain;
+        const ClothoidChain *chain;
+        unsigned int revision;
+        Length leftOffset;
+        // Index of the current clothoid
+        size_t index;
+        // Parallel lengths along the chain at the start and end of it
+        Length startLength, endLength;
+
+    public:
+        Cursor()
+        : chain(nullptr),
+          revision(0),
+          leftOffset(0),
+          index(0),
+          startLength(0),
+          endLength(0)
+        {
+        }
+
+        // Forget the cached location
+        void reset()
+        {
+            chain = nullptr;
+        }
+    };
+
+    // Result of projecting a point onto the chain
+    struct Projection {
+        // Clothoid index and length along it of the closest point
+        size_t index;
+        Length length;
+        // Length along the whole chain of the closest point
+        Length chainLength;
+        // Signed distance of the point to the left of the chain
+        Length leftOffset;
+        Length distance;
+    };
+
+    // Maximum distance of the projection seed tessellation from the chain
+    static constexpr Length seedTolerance = (Length)0.1;
 
     // Constructor
     ClothoidChain()
+    : revision(0)
     {
     }
 
-    // Append a clothoid
+    // Append a clothoid, following on from the last one.
+    // The returned pointer is only valid until the next append.
     Clothoid *append()
     {
+        ++revision;
         if (chain.empty()) {
             chain.push_back(Clothoid());
+            startLengths.push_back(0);
+            startDirectionChanges.push_back(0);
         } else {
-            chain.push_back(chain.back().getNextClothoid());
+            const Clothoid &last = chain.back();
+            startLengths.push_back(startLengths.back() + last.getLength());
+            startDirectionChanges.push_back(startDirectionChanges.back() +
+                                            last.getEndDirectionChange());
+            addSeeds(chain.size() - 1);
+            chain.push_back(last.getNextClothoid());
         }
         return &chain.back();
     }
@@ -42,7 +127,11 @@ public:
     // Clear the chain
     void clear()
     {
+        ++revision;
         chain.clear();
+        startLengths.clear();
+        startDirectionChanges.clear();
+        seeds.clear();
     }
 
     // Clothoid accessors
@@ -55,46 +144,216 @@ public:
 
     Length length() const
     {
-        Length length = 0;
-        for (const Clothoid &clothoid: chain)
-            length += clothoid.getLength();
-        return length;
+        if (chain.empty())
+            return 0;
+        return startLengths.back();
     }
 
     Length parallelLength(Length leftOffset) const
     {
-        Length length = 0;
-        for (const Clothoid &clothoid: chain)
-            length += clothoid.getParallelLength(leftOffset);
-        return length;
+        if (chain.empty())
+            return 0;
+        return startLengths.back() - leftOffset * startDirectionChanges.back();
+    }
+    // Find the length along a parallel up to length along clothoid index,
+    // such as of a projection
+    Length parallelLengthAtLength(Length leftOffset, size_t index, Length length) const
+    {
+        return parallelStartLength(leftOffset, index) + length
+             - leftOffset * chain[index].directionChangeAtLength(length);
     }
 
     Vec2l positionAtLength(Length length) const
     {
         if (length <= 0)
             return chain.front().getStartPosition();
-        for (const Clothoid &clothoid: chain) {
-            Length clothoidLength = clothoid.getLength();
-            if (length < clothoidLength)
-                return clothoid.positionAtLength(length);
-            length -= clothoidLength;
-        }
-        return chain.back().getStartPosition();
+        // Last clothoid starting at or before length
+        size_t i = std::upper_bound(startLengths.begin(), startLengths.end(),
+                                    length) - startLengths.begin() - 1;
+        if (i + 1 >= chain.size())
+            return chain.back().getStartPosition();
+        return chain[i].positionAtLength(length - startLengths[i]);
     }
 
     Vec2l parallelPositionAtParallelLength(Length leftOffset, Length length,
                                            Mat22l *outRotMatrix = nullptr) const
+    {
+        size_t index = parallelIndex(leftOffset, length);
+        return parallelPositionInClothoid(leftOffset, length, index,
+                                          parallelStartLength(leftOffset, index),
+                                          outRotMatrix);
+    }
+
+    // As above, but starting the search from cursor and updating it
+    Vec2l parallelPositionAtParallelLength(Cursor *cursor,
+                                           Length leftOffset, Length length,
+                                           Mat22l *outRotMatrix = nullptr) const
+    {
+        seek(cursor, leftOffset, length);
+        return parallelPositionInClothoid(leftOffset, length, cursor->index,
+                                          cursor->startLength, outRotMatrix);
+    }
+
+    // Find the closest point on the chain to point, to within tolerance
+    // along the chain. The closest segment of a coarse tessellation brackets
+    // a search on the clothoids. Returns false if the chain has no length.
+    bool project(const Vec2l &point, Projection *out,
+                 Length tolerance = (Length)1e-4) const
+    {
+        size_t best = seeds.size();
+        Length bestDistanceSqr = std::numeric_limits<Length>::max();
+        Length bestFraction = 0;
+        for (size_t i = 0; i + 1 < seeds.size(); ++i) {
+            if (seeds[i].index != seeds[i + 1].index)
+                continue;
+            Vec2l segment = seeds[i + 1].position - seeds[i].position;
+            Vec2l offset = point - seeds[i].position;
+            Length segmentSqr = segment.sqr();
+            Length fraction = segmentSqr > 0 ? offset * segment / segmentSqr : 0;
+            fraction = std::min(std::max(fraction, (Length)0), (Length)1);
+            Length distanceSqr = (offset - segment * fraction).sqr();
+            if (distanceSqr < bestDistanceSqr) {
+                best = i;
+                bestDistanceSqr = distanceSqr;
+                bestFraction = fraction;
+            }
+        }
+        if (best == seeds.size())
+            return false;
+
+        // Search the clothoid around the closest segment
+        size_t index = seeds[best].index;
+        Length from = seeds[best].length;
+        Length to = seeds[best + 1].length;
+        Length guess = from + (to - from) * bestFraction;
+        if (best > 0 && seeds[best - 1].index == index)
+            from = seeds[best - 1].length;
+        if (best + 2 < seeds.size() && seeds[best + 2].index == index)
+            to = seeds[best + 2].length;
+        projectOnClothoid(point, index, from, to, guess, tolerance, out);
+
+        // The closest point may be just over the boundary with a neighbour
+        Projection neighbour;
+        const Clothoid &clothoid = chain[index];
+        if (out->length >= clothoid.getLength()) {
+            for (size_t next = index + 1; next + 1 < chain.size(); ++next) {
+                if (chain[next].getLength() > 0) {
+                    projectOnClothoid(point, next, 0, chain[next].getLength(), 0,
+                                      tolerance, &neighbour);
+                    if (neighbour.distance < out->distance)
+                        *out = neighbour;
+                    break;
+                }
+            }
+        } else if (out->length <= 0) {
+            for (size_t prev = index; prev-- > 0;) {
+                if (chain[prev].getLength() > 0) {
+                    projectOnClothoid(point, prev, 0, chain[prev].getLength(),
+                                      chain[prev].getLength(), tolerance, &neighbour);
+                    if (neighbour.distance < out->distance)
+                        *out = neighbour;
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Move cursor to the clothoid containing length along a parallel
+    void seek(Cursor *cursor, Length leftOffset, Length length) const
+    {
+        if (cursor->chain == this && cursor->revision == revision &&
+                cursor->leftOffset == leftOffset) {
+            if ((length >= cursor->startLength || !cursor->index) &&
+                    length < cursor->endLength)
+                return;
+            // Step to neighbouring clothoids
+            size_t index = cursor->index;
+            while (index + 1 < chain.size() &&
+                   parallelStartLength(leftOffset, index + 1) <= length)
+                ++index;
+            while (index > 0 && parallelStartLength(leftOffset, index) > length)
+                --index;
+            cursor->index = index;
+        } else {
+            cursor->chain = this;
+            cursor->revision = revision;
+            cursor->leftOffset = leftOffset;
+            cursor->index = parallelIndex(leftOffset, length);
+        }
+
+        size_t index = cursor->index;
+        cursor->startLength = parallelStartLength(leftOffset, index);
+        cursor->endLength = index + 1 < chain.size() ? parallelStartLength(leftOffset, index + 1)
+                                                     : std::numeric_limits<Length>::max();
+    }
+
+private:
+    Length parallelStartLength(Length leftOffset, size_t index) const
+    {
+        return startLengths[index] - leftOffset * startDirectionChanges[index];
+    }
+
+    // Find the last clothoid starting at or before length along a parallel
+    size_t parallelIndex(Length leftOffset, Length length) const
+    {
+        size_t first = 1, count = chain.size() - 1;
+        while (count > 0) {
+            size_t half = count / 2;
+            size_t mid = first + half;
+            if (parallelStartLength(leftOffset, mid) <= length) {
+                first = mid + 1;
+                count -= half + 1;
+            } else {
+                count = half;
+            }
+        }
+        return first - 1;
+    }
+
+    // Add seed vertices for projection of a completed clothoid
+    void addSeeds(size_t index)
+    {
+        const Clothoid &clothoid = chain[index];
+        Length length = clothoid.getLength();
+        if (length <= 0)
+            return;
+        Length len = 0;
+        for (;;) {
+            seeds.push_back({ clothoid.positionAtLength(len), index, len });
+            if (len >= length)
+                break;
+            len += clothoid.parallelTessellationStep(0, len, seedTolerance);
+        }
+    }
+
+    void projectOnClothoid(const Vec2l &point, size_t index, Length from, Length to,
+                           Length guess, Length tolerance, Projection *out) const
+    {
+        const Clothoid &clothoid = chain[index];
+        Length length = clothoid.closestLength(point, from, to, guess, tolerance);
+        Vec2l offset = point - clothoid.positionAtLength(length);
+        Vec2l leftVec;
+        maths::sincos((Length)(clothoid.directionAtLength(length) + M_PI/2),
+                      &leftVec[1], &leftVec[0]);
+        out->index = index;
+        out->length = length;
+        out->chainLength = startLengths[index] + length;
+        out->leftOffset = offset * leftVec;
+        out->distance = offset.mag();
+    }
+
+    Vec2l parallelPositionInClothoid(Length leftOffset, Length length,
+                                     size_t index, Length startLength,
+                                     Mat22l *outRotMatrix) const
     {
         if (length <= 0) {
             return chain.front().getStartParallelPosition(leftOffset, outRotMatrix);
         }
-        for (const Clothoid &clothoid: chain) {
-            Length clothoidLength = clothoid.getParallelLength(leftOffset);
-            if (length < clothoidLength)
-                return clothoid.parallelPositionAtParallelLength(leftOffset, length, outRotMatrix);
-            length -= clothoidLength;
-        }
-        return chain.back().getStartParallelPosition(leftOffset, outRotMatrix);
+        if (index + 1 >= chain.size())
+            return chain.back().getStartParallelPosition(leftOffset, outRotMatrix);
+        return chain[index].parallelPositionAtParallelLength(leftOffset,
+                        length - startLength, outRotMatrix);
     }
 };
 
@@ -0,0 +1,167 @@
+#ifndef TRAINS_CLOTHOID_PACKET_H
+#define TRAINS_CLOTHOID_PACKET_H
+
+#include <Clothoid.h>
+
+/*
+ * N float clothoids stored as a structure of arrays, so that the same
+ * calculation can be made on each of them in lockstep, such as for each
+ * candidate shape of a track section. The Fresnel integrals of all lanes
+ * are evaluated together with F::calcBatch() (SSE2 or AVX2 for the exact
+ * policy), and the remaining per-lane arithmetic is kept in simple loops
+ * over the lanes. Results match Clothoid to within a few ulps.
+ */
+template <unsigned int N, typename F = FresnelExact>
+class ClothoidPacket
+{
+public:
+    typedef Clothoid<float, float, F> ClothoidT;
+    typedef maths::Vector<2, float> Vec2f;
+    enum { width = N };
+
+    float startX[N], startY[N];
+    float startDirection[N];
+    float startCurvature[N];
+    float curvatureRate[N];
+    float length[N];
+
+    ClothoidPacket()
+    {
+        for (unsigned int i = 0; i < N; ++i) {
+            startX[i] = startY[i] = 0;
+            startDirection[i] = 0;
+            startCurvature[i] = 0;
+            curvatureRate[i] = 0;
+            length[i] = 0;
+        }
+    }
+
+    // Lane access
+
+    void set(unsigned int i, const ClothoidT &clothoid)
+    {
+        Vec2f start = clothoid.getStartPosition();
+        startX[i] = start[0];
+        startY[i] = start[1];
+        startDirection[i] = clothoid.getStartDirection();
+        startCurvature[i] = clothoid.getStartCurvature();
+        curvatureRate[i] = clothoid.getCurvatureRate();
+        length[i] = clothoid.getLength();
+    }
+    ClothoidT get(unsigned int i) const
+    {
+        ClothoidT ret;
+        ret.setStartPosition(Vec2f(startX[i], startY[i]));
+        ret.setStartDirection(startDirection[i]);
+        ret.setStartCurvature(startCurvature[i]);
+        ret.setCurvatureRate(curvatureRate[i]);
+        ret.setLength(length[i]);
+        return ret;
+    }
+    Vec2f getStartPosition(unsigned int i) const
+    {
+        return Vec2f(startX[i], startY[i]);
+    }
+
+    // Calculators, each filling N outputs
+
+    void directionsAtLengths(const float *lengths, float *outDirections) const
+    {
+        for (unsigned int i = 0; i < N; ++i)
+            outDirections[i] = startDirection[i] + lengths[i] * (startCurvature[i] +
+                                                                 curvatureRate[i] * lengths[i] / 2);
+    }
+    void getEndDirections(float *outDirections) const
+    {
+        directionsAtLengths(length, outDirections);
+    }
+
+    void curvaturesAtLengths(const float *lengths, float *outCurvatures) const
+    {
+        for (unsigned int i = 0; i < N; ++i)
+            outCurvatures[i] = startCurvature[i] + curvatureRate[i] * lengths[i];
+    }
+    void getEndCurvatures(float *outCurvatures) const
+    {
+        curvaturesAtLengths(length, outCurvatures);
+    }
+
+    // Find centres of turning circles at the start
+    void circlesAtStart(Vec2f *outCircles) const
+    {
+        for (unsigned int i = 0; i < N; ++i) {
+            Vec2f directionVec;
+            maths::sincos((float)(startDirection[i] + M_PI/2), &directionVec[1], &directionVec[0]);
+            outCircles[i] = Vec2f(startX[i], startY[i]) + directionVec / startCurvature[i];
+        }
+    }
+
+    // As Clothoid::positionAtLength() for each lane
+    void positionsAtLengths(const float *lengths, Vec2f *outPositions) const
+    {
+        constexpr float invSqrt2 = (float)(1/M_SQRT2);
+        float fresnelScale[N], args[2 * N];
+        for (unsigned int i = 0; i < N; ++i) {
+            float rateSqrt = sqrtf(fabsf(curvatureRate[i]));
+            fresnelScale[i] = (curvatureRate[i] < 0 ? -rateSqrt : rateSqrt) / invSqrt2 / 2;
+            // Length from zero curvature, or 0 for circles and straights
+            float lengthOffs = curvatureRate[i] != 0 ? startCurvature[i] / curvatureRate[i] : 0;
+            args[i] = lengthOffs * fresnelScale[i];
+            args[N + i] = (lengths[i] + lengthOffs) * fresnelScale[i];
+        }
+        Vec2f fres[2 * N];
+        F::calcBatch(args, fres, 2 * N);
+
+        for (unsigned int i = 0; i < N; ++i) {
+            Vec2f offset;
+            float fresRotation;
+            if (curvatureRate[i] != 0) {
+                offset = (fres[N + i] - fres[i]) / fresnelScale[i];
+                fresRotation = fresnelDirection(args[i]);
+                // Compensate for negative change in curvature
+                if (curvatureRate[i] < 0) {
+                    offset[1] = -offset[1];
+                    fresRotation = -fresRotation;
+                }
+            } else if (startCurvature[i] != 0) {
+                // Circle
+                float radius = 1.0f / startCurvature[i];
+                float absRadius = fabsf(radius);
+                float sin, cos;
+                maths::sincos(lengths[i] / absRadius, &sin, &cos);
+                offset = Vec2f(sin * absRadius, radius - cos * radius);
+                fresRotation = 0;
+            } else {
+                // Straight line
+                offset = Vec2f(lengths[i], 0);
+                fresRotation = 0;
+            }
+
+            float sin, cos;
+            maths::sincos(startDirection[i] - fresRotation, &sin, &cos);
+            outPositions[i] = Vec2f(startX[i] + cos * offset[0] - sin * offset[1],
+                                    startY[i] + sin * offset[0] + cos * offset[1]);
+        }
+    }
+    void getEndPositions(Vec2f *outPositions) const
+    {
+        positionsAtLengths(length, outPositions);
+    }
+
+    // Get clothoids that follow on from each lane, with zero rate and length
+    ClothoidPacket getNextClothoids() const
+    {
+        ClothoidPacket ret;
+        Vec2f positions[N];
+        getEndPositions(positions);
+        getEndDirections(ret.startDirection);
+        getEndCurvatures(ret.startCurvature);
+        for (unsigned int i = 0; i < N; ++i) {
+            ret.startX[i] = positions[i][0];
+            ret.startY[i] = positions[i][1];
+        }
+        return ret;
+    }
+};
+
+#endif // TRAINS_CLOTHOID_PACKET_H
@@ -0,0 +1,194 @@
+#include "Fresnel.h"
+#include "FresnelApproximation.h"
+#include "FresnelBatch.h"
+
+#include <cmath>
+
+template <typename T>
+maths::Vector<2, T> fresnel(T x)
+{
+    typedef Fresnel::Approximation<T> Approx;
+    maths::Vector<2, T> ret;
+
+    T xMag = x < 0 ? -x : x;
+    if (xMag < 2) {
+        T x2 = x * x;
+        T t = x2 * x2 * (T)(1.0/8) - 1;
+        ret[0] = x * Fresnel::polynomial(Approx::smallC, t);
+        ret[1] = x * x2 * Fresnel::polynomial(Approx::smallS, t);
+        return ret;
+    }
+
+    T inv = 1 / xMag;
+    T f, g;
+    if (xMag < 4) {
+        T t = inv * 8 - 3;
+        f = Fresnel::polynomial(Approx::midF4, t);
+        g = Fresnel::polynomial(Approx::midG4, t);
+    } else if (xMag < 8) {
+        T t = inv * 16 - 3;
+        f = Fresnel::polynomial(Approx::midF8, t);
+        g = Fresnel::polynomial(Approx::midG8, t);
+    } else {
+        T v = inv * inv;
+        v *= v;
+        f = Fresnel::polynomial(Approx::asymptoticF, v);
+        g = Fresnel::polynomial(Approx::asymptoticG, v);
+    }
+    f *= inv;
+    g *= inv * inv * inv;
+
+    const T limit = (T)0.62665706865775012560394;  // sqrt(pi/8)
+    T sin, cos;
+    maths::sincos(xMag * xMag, &sin, &cos);
+    ret[0] = limit + f * sin - g * cos;
+    ret[1] = limit - g * sin - f * cos;
+    if (x < 0)
+        ret = -ret;
+    return ret;
+}
+
+template maths::Vector<2, float> fresnel<float>(float x);
+template maths::Vector<2, double> fresnel<double>(double x);
+
+namespace Fresnel {
+    // Compile time sin and cos, for table generation
+    constexpr void constSinCos(double y, double *outSin, double *outCos)
+    {
+        constexpr double twoPi = 6.283185307179586476925;
+        long turns = (long)(y / twoPi + (y < 0 ? -0.5 : 0.5));
+        y -= turns * twoPi;
+
+        // Taylor series for |y| <= pi
+        double sinTerm = y, cosTerm = 1;
+        *outSin = *outCos = 0;
+        for (int n = 1; n < 40; n += 2) {
+            *outSin += sinTerm;
+            *outCos += cosTerm;
+            sinTerm *= -y * y / ((n + 1) * (n + 2));
+            cosTerm *= -y * y / (n * (n + 1));
+        }
+    }
+
+    // Table of C, S and derivatives multiplied by node spacing
+    template <typename T>
+    struct HermiteTable
+    {
+        static constexpr unsigned int nodesPerUnit = 64;
+        static constexpr unsigned int maxX = 8;
+        static constexpr unsigned int numNodes = nodesPerUnit * maxX + 1;
+
+        struct Node {
+            T c, s;
+            T dc, ds;
+        };
+        Node nodes[numNodes];
+
+        constexpr HermiteTable()
+        : nodes()
+        {
+            // Integrate between nodes with 5 point Gauss-Legendre quadrature
+            const double glNodes[5] = {
+                -0.9061798459386639927976, -0.5384693101056830910363, 0,
+                0.5384693101056830910363, 0.9061798459386639927976
+            };
+            const double glWeights[5] = {
+                0.2369268850561890875143, 0.4786286704993664680413,
+                0.5688888888888888888889,
+                0.4786286704993664680413, 0.2369268850561890875143
+            };
+            const double h = 1.0 / nodesPerUnit;
+            double c = 0, s = 0;
+            for (unsigned int i = 0; i < numNodes; ++i) {
+                double x = h * i;
+                double sin = 0, cos = 0;
+                constSinCos(x * x, &sin, &cos);
+                nodes[i].c = (T)c;
+                nodes[i].s = (T)s;
+                nodes[i].dc = (T)(h * cos);
+                nodes[i].ds = (T)(h * sin);
+
+                for (unsigned int k = 0; k < 5; ++k) {
+                    double t = x + h / 2 * (1 + glNodes[k]);
+                    constSinCos(t * t, &sin, &cos);
+                    c += h / 2 * glWeights[k] * cos;
+                    s += h / 2 * glWeights[k] * sin;
+                }
+            }
+        }
+    };
+
+    template <typename T>
+    constexpr HermiteTable<T> hermiteTable;
+}
+
+template <typename T>
+maths::Vector<2, T> fresnelTable(T x)
+{
+    typedef Fresnel::HermiteTable<T> Table;
+    T xMag = x < 0 ? -x : x;
+    if (!(xMag < Table::maxX))
+        return fresnel(x);
+
+    T pos = xMag * Table::nodesPerUnit;
+    unsigned int i = (unsigned int)pos;
+    T u = pos - i;
+    const typename Table::Node &a = Fresnel::hermiteTable<T>.nodes[i];
+    const typename Table::Node &b = Fresnel::hermiteTable<T>.nodes[i + 1];
+
+    // Cubic Hermite basis functions
+    T u2 = u * u;
+    T u3 = u2 * u;
+    T h01 = 3 * u2 - 2 * u3;
+    T h00 = 1 - h01;
+    T h10 = u3 - 2 * u2 + u;
+    T h11 = u3 - u2;
+
+    maths::Vector<2, T> ret;
+    ret[0] = h00 * a.c + h10 * a.dc + h01 * b.c + h11 * b.dc;
+    ret[1] = h00 * a.s + h10 * a.ds + h01 * b.s + h11 * b.ds;
+    if (x < 0)
+        ret = -ret;
+    return ret;
+}
+
+template maths::Vector<2, float> fresnelTable<float>(float x);
+template maths::Vector<2, double> fresnelTable<double>(double x);
+
+namespace Fresnel {
+    void batchScalar(const float *x, maths::Vector<2, float> *out, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+            out[i] = fresnel(x[i]);
+    }
+
+    typedef void (*BatchFunc)(const float *x, maths::Vector<2, float> *out, size_t n);
+
+    static BatchFunc chooseBatch()
+    {
+#if defined(__i386) || defined(__x86_64)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return &batchAVX2;
+        if (__builtin_cpu_supports("sse2"))
+            return &batchSSE2;
+#endif
+        return &batchScalar;
+    }
+}
+
+template <typename T>
+void fresnelBatch(const T *x, maths::Vector<2, T> *out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        out[i] = fresnel(x[i]);
+}
+
+template <>
+void fresnelBatch<float>(const float *x, maths::Vector<2, float> *out, size_t n)
+{
+    static const Fresnel::BatchFunc batch = Fresnel::chooseBatch();
+    batch(x, out, n);
+}
+
+template void fresnelBatch<double>(const double *x, maths::Vector<2, double> *out, size_t n);
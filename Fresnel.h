@@ -3,6 +3,8 @@
 
 #include <maths/Vector.h>
 
+#include <cstddef>
+
 namespace Fresnel {
     template <typename T>
     constexpr T Factorial(T x)
@@ -100,30 +102,95 @@ namespace Fresnel {
             return FresnelPowerExpansion<0>::calc(x);
         }
     };
+
+    // Truncated power series, only accurate for small x.
+    // Kept for comparison, use fresnel() instead.
+    template <typename T>
+    maths::Vector<2, T> powerSeries(T x)
+    {
+        T xMag = x < 0 ? -x : x;
+        maths::Vector<2, T> ret = FresnelPowerExpansion<0>::calc(x);
+        switch ((unsigned int)(xMag * 5)) {
+        default:ret += FresnelPowerExpansion<9>::calc(x);
+        case 8: ret += FresnelPowerExpansion<8>::calc(x);
+        case 7: ret += FresnelPowerExpansion<7>::calc(x);
+        case 6: ret += FresnelPowerExpansion<6>::calc(x);
+        case 5: ret += FresnelPowerExpansion<5>::calc(x);
+        case 4: ret += FresnelPowerExpansion<4>::calc(x);
+        case 3: ret += FresnelPowerExpansion<3>::calc(x);
+        case 2: ret += FresnelPowerExpansion<2>::calc(x);
+        case 1: ret += FresnelPowerExpansion<1>::calc(x);
+        case 0: ;
+        }
+        return ret;
+    }
 }
 
+// Fresnel integrals C(x) = integral of cos(t²) and S(x) = integral of sin(t²)
+// from 0 to x, returned as (C, S).
+// Instantiated for float and double in Fresnel.cpp.
+template <typename T>
+maths::Vector<2, T> fresnel(T x);
+
+extern template maths::Vector<2, float> fresnel<float>(float x);
+extern template maths::Vector<2, double> fresnel<double>(double x);
+
+// Evaluate fresnel() for each of n arguments.
+// The float version uses SSE2 or AVX2 where available, chosen at runtime.
+template <typename T>
+void fresnelBatch(const T *x, maths::Vector<2, T> *out, size_t n);
+
+template <>
+void fresnelBatch<float>(const float *x, maths::Vector<2, float> *out, size_t n);
+extern template void fresnelBatch<double>(const double *x, maths::Vector<2, double> *out, size_t n);
+
+// Fresnel integrals by cubic Hermite interpolation of a table generated at
+// compile time, using that the derivatives are cos(x²) and sin(x²).
+// Instantiated for float and double in Fresnel.cpp.
+// For |x| < 8 the interpolation error is bounded by M h⁴ / 384, where the
+// node spacing h = 1/64 and M = 12|x| + 8|x|³ bounds the 4th derivative,
+// i.e. below 7e-7 (and below 1e-8 for |x| < 2), plus rounding of the table.
+// Beyond that it falls back to fresnel().
 template <typename T>
-maths::Vector<2, T> fresnel(T x)
+maths::Vector<2, T> fresnelTable(T x);
+
+extern template maths::Vector<2, float> fresnelTable<float>(float x);
+extern template maths::Vector<2, double> fresnelTable<double>(double x);
+
+// Policies for selecting how Clothoid evaluates Fresnel integrals
+
+// Accurate to near machine precision, for solvers
+struct FresnelExact
 {
-    // TODO Perform some measurement to see if this is a decent implementation
-    // and check whether the compiler generates something sensible
-    // TODO extern template this into a C file for float and double
-    T xMag = x < 0 ? -x : x;
-    maths::Vector<2, T> ret = Fresnel::FresnelPowerExpansion<0>::calc(x);
-    switch ((unsigned int)(xMag * 5)) {
-    default:ret += Fresnel::FresnelPowerExpansion<9>::calc(x);
-    case 8: ret += Fresnel::FresnelPowerExpansion<8>::calc(x);
-    case 7: ret += Fresnel::FresnelPowerExpansion<7>::calc(x);
-    case 6: ret += Fresnel::FresnelPowerExpansion<6>::calc(x);
-    case 5: ret += Fresnel::FresnelPowerExpansion<5>::calc(x);
-    case 4: ret += Fresnel::FresnelPowerExpansion<4>::calc(x);
-    case 3: ret += Fresnel::FresnelPowerExpansion<3>::calc(x);
-    case 2: ret += Fresnel::FresnelPowerExpansion<2>::calc(x);
-    case 1: ret += Fresnel::FresnelPowerExpansion<1>::calc(x);
-    case 0: ;
+    template <typename T>
+    static maths::Vector<2, T> calc(T x)
+    {
+        return fresnel(x);
     }
-    return ret;
-}
+
+    template <typename T>
+    static void calcBatch(const T *x, maths::Vector<2, T> *out, size_t n)
+    {
+        fresnelBatch(x, out, n);
+    }
+};
+
+// Faster table lookup, for rendering and interactive feedback
+struct FresnelTable
+{
+    template <typename T>
+    static maths::Vector<2, T> calc(T x)
+    {
+        return fresnelTable(x);
+    }
+
+    template <typename T>
+    static void calcBatch(const T *x, maths::Vector<2, T> *out, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+            out[i] = fresnelTable(x[i]);
+    }
+};
 
 template <typename T>
 T fresnelDirection(T x)
@@ -0,0 +1,130 @@
+#ifndef TRAINS_FRESNEL_APPROXIMATION_H
+#define TRAINS_FRESNEL_APPROXIMATION_H
+
+// Internal to the Fresnel.cpp and FresnelBatch*.cpp implementations
+
+/*
+ * C(x) and S(x) are evaluated in three ranges of |x|, both being odd:
+ *
+ * |x| < 2: C(x) = x P(x⁴), S(x) = x³ Q(x⁴), where P and Q are entire, so are
+ *          well approximated by Chebyshev fits in t = x⁴/8 - 1.
+ *
+ * |x| >= 2: In terms of the auxiliary functions f and g,
+ *          C(x) = sqrt(pi/8) + f(x) sin(x²) - g(x) cos(x²)
+ *          S(x) = sqrt(pi/8) - g(x) sin(x²) - f(x) cos(x²)
+ *          with f(x) = F(1/x) / x and g(x) = G(1/x) / x³.
+ *          For |x| < 8, F and G are Chebyshev fits in 1/x over [2, 4) and
+ *          [4, 8). Beyond that the asymptotic expansions in v = 1/x⁴ are used:
+ *          F = sum (-1)^m (4m-1)!! / 2^(2m+1) v^m
+ *          G = sum (-1)^m (4m+1)!! / 2^(2m+2) v^m
+ *
+ * Coefficients are in increasing powers. The fits were made in high precision
+ * with an absolute error in C and S below 2e-8 for float and 4e-17 for double,
+ * see bench/FresnelBench.cpp for measurements.
+ */
+
+namespace Fresnel {
+    template <typename T>
+    struct Approximation;
+
+    template <>
+    struct Approximation<float>
+    {
+        static constexpr float smallC[] = {
+            4.471622510e-01f, -3.496313448e-01f, 1.640596909e-01f, -3.468785317e-02f,
+            4.126664984e-03f, -3.147811811e-04f, 1.675856903e-05f, -6.552183323e-07f
+        };
+        static constexpr float smallS[] = {
+            1.851293995e-01f, -1.116171019e-01f, 3.139727673e-02f, -4.723609153e-03f,
+            4.372865536e-04f, -2.742433067e-05f, 1.234454732e-06f
+        };
+        static constexpr float midF4[] = {
+            4.935089710e-01f, -7.719311539e-03f, -2.876939290e-03f, -1.228774591e-04f,
+            1.103385296e-04f, -1.301946861e-06f, -4.751921127e-06f
+        };
+        static constexpr float midG4[] = {
+            2.351753967e-01f, -1.634976033e-02f, -4.865462852e-03f, 4.143171932e-04f,
+            2.564710390e-04f, -4.471968668e-05f, -8.962834484e-06f
+        };
+        static constexpr float midF8[] = {
+            4.995413818e-01f, -6.054239038e-04f, -2.944337269e-04f, -5.839394090e-05f,
+            -2.080661602e-06f
+        };
+        static constexpr float midG8[] = {
+            2.488628433e-01f, -1.488784752e-03f, -7.081686975e-04f, -1.287963289e-04f
+        };
+        static constexpr float asymptoticF[] = {
+            1.0f/2, -3.0f/8, 105.0f/32
+        };
+        static constexpr float asymptoticG[] = {
+            1.0f/4, -15.0f/16, 945.0f/64
+        };
+    };
+
+    template <>
+    struct Approximation<double>
+    {
+        static constexpr double smallC[] = {
+            4.47162251153604418e-01, -3.49631344819862966e-01, 1.64059685983198394e-01,
+            -3.46878530553754519e-02, 4.12668957535235626e-03, -3.14781766182804627e-04,
+            1.67192300500335818e-05, -6.54282325586096583e-07, 1.96570546565976193e-08,
+            -4.67804416402191388e-10, 9.04424494194612191e-12, -1.44688377581398434e-13
+        };
+        static constexpr double smallS[] = {
+            1.85129399491932134e-01, -1.11617097354341083e-01, 3.13972766110309776e-02,
+            -4.72364586130566769e-03, 4.37287528889821278e-04, -2.73509294003513070e-05,
+            1.23250446399414271e-06, -4.19138547092445364e-08, 1.11391780631109684e-09,
+            -2.37740016077424578e-11, 4.16690840253861462e-13, -6.09826194775638360e-15
+        };
+        static constexpr double midF4[] = {
+            4.93508971036110911e-01, -7.71939251225480742e-03, -2.87695439988087161e-03,
+            -1.22222051968414797e-04, 1.10458729521955925e-04, -2.65881066804192941e-06,
+            -4.98813313575759915e-06, 8.64927535811158463e-07, 1.26268126030444677e-07,
+            -7.49890022015464255e-08, 8.33650765808589218e-09, 2.89821183094585430e-09,
+            -1.30073355702854065e-09, 1.44877410511229606e-10, 5.26829163299242144e-11,
+            -2.22065794066526644e-11, 2.20163316170011593e-12
+        };
+        static constexpr double midG4[] = {
+            2.35175396749673637e-01, -1.63502557118964734e-02, -4.86543083373478652e-03,
+            4.18308273155654773e-04, 2.56205745083017058e-04, -5.28696297599595379e-05,
+            -8.37673812070984494e-06, 4.97492523626637838e-06, -4.44096895618227192e-07,
+            -2.49890992344128544e-07, 9.35606705664035274e-08, -6.03295748514087722e-09,
+            -5.48939000546332508e-09, 2.12692697173747112e-09, -1.96714853491636518e-10,
+            -1.26645822304509639e-10, 4.32282327874793902e-11
+        };
+        static constexpr double midF8[] = {
+            4.99541381826361264e-01, -6.05183743956340891e-04, -2.94413597079208980e-04,
+            -5.93572278957219007e-05, -2.16181266346176687e-06, 7.79142665285498444e-07,
+            6.69616662093087569e-08, -8.63637983273846597e-09, -2.09809963459316378e-09,
+            1.33961084782772466e-10, 6.28126666256759920e-11, -2.64999814536974016e-12,
+            -1.86646299658118843e-12
+        };
+        static constexpr double midG8[] = {
+            2.48862915297246579e-01, -1.48842453519955993e-03, -7.08727921188900801e-04,
+            -1.31685331642108859e-04, 4.39038865135129024e-07, 2.94008216084334677e-06,
+            1.43681243734317568e-07, -5.97205818945394234e-08, -7.62734151195539598e-09,
+            1.60962850227706619e-09, 2.96188712396077258e-10, -4.85505780366532976e-11,
+            -1.00968416841244381e-11
+        };
+        static constexpr double asymptoticF[] = {
+            1.0/2, -3.0/8, 105.0/32, -10395.0/128, 2027025.0/512,
+            -654729075.0/2048, 316234143225.0/8192, -213458046676875.0/32768
+        };
+        static constexpr double asymptoticG[] = {
+            1.0/4, -15.0/16, 945.0/64, -135135.0/256, 34459425.0/1024,
+            -13749310575.0/4096, 7905853580625.0/16384, -6190283353629375.0/65536
+        };
+    };
+
+    // Evaluate a polynomial using Horner's method
+    template <typename T, unsigned int N>
+    inline T polynomial(const T (&coefficients)[N], T t)
+    {
+        T ret = coefficients[N - 1];
+        for (int i = N - 2; i >= 0; --i)
+            ret = ret * t + coefficients[i];
+        return ret;
+    }
+}
+
+#endif // TRAINS_FRESNEL_APPROXIMATION_H
@@ -0,0 +1,164 @@
+#ifndef TRAINS_FRESNEL_BATCH_H
+#define TRAINS_FRESNEL_BATCH_H
+
+// Internal to the FresnelBatch*.cpp implementations
+
+#include "Fresnel.h"
+#include "FresnelApproximation.h"
+
+#include <cstddef>
+
+namespace Fresnel {
+    // Instruction set specific batch implementations, see fresnelBatch()
+    void batchSSE2(const float *x, maths::Vector<2, float> *out, size_t n);
+    void batchAVX2(const float *x, maths::Vector<2, float> *out, size_t n);
+
+    /*
+     * Vector implementation of fresnel<float>(), generic over the Ops
+     * abstraction of an instruction set (see FresnelBatchSSE2.cpp).
+     * The same approximation ranges and coefficients are used as the scalar
+     * version, but sin and cos of x² are calculated with a vectorised Cephes
+     * style polynomial, so results may differ by a few ulps.
+     */
+    template <typename Ops>
+    class BatchKernel
+    {
+    private:
+        typedef typename Ops::Vec Vec;
+        typedef typename Ops::IVec IVec;
+        typedef Approximation<float> Approx;
+
+        // Cody-Waite range reduction is accurate up to this argument
+        static constexpr float maxSinCosArg = 8192.0f;
+
+        template <unsigned int N>
+        static inline Vec polynomial(const float (&coefficients)[N], Vec t)
+        {
+            Vec ret = Ops::set1(coefficients[N - 1]);
+            for (int i = N - 2; i >= 0; --i)
+                ret = Ops::fmadd(ret, t, Ops::set1(coefficients[i]));
+            return ret;
+        }
+
+        // Calculate sin and cos of non-negative y
+        static inline void sincos(Vec y, Vec *outSin, Vec *outCos)
+        {
+            // Octant, rounded up to even
+            IVec j = Ops::cvttps(Ops::mul(y, Ops::set1((float)(4 / M_PI))));
+            j = Ops::iand(Ops::iadd(j, Ops::iset1(1)), Ops::iset1(~1));
+            Vec yj = Ops::cvtepi32(j);
+
+            // Extended precision modular arithmetic
+            Vec r = Ops::fmadd(yj, Ops::set1(-0.78515625f), y);
+            r = Ops::fmadd(yj, Ops::set1(-2.4187564849853515625e-4f), r);
+            r = Ops::fmadd(yj, Ops::set1(-3.77489497744594108e-8f), r);
+            Vec z = Ops::mul(r, r);
+
+            Vec sinPoly = Ops::fmadd(Ops::set1(-1.9515295891e-4f), z, Ops::set1(8.3321608736e-3f));
+            sinPoly = Ops::fmadd(sinPoly, z, Ops::set1(-1.6666654611e-1f));
+            sinPoly = Ops::fmadd(Ops::mul(sinPoly, z), r, r);
+
+            Vec cosPoly = Ops::fmadd(Ops::set1(2.443315711809948e-5f), z, Ops::set1(-1.388731625493765e-3f));
+            cosPoly = Ops::fmadd(cosPoly, z, Ops::set1(4.166664568298827e-2f));
+            cosPoly = Ops::fmadd(Ops::mul(cosPoly, z), z, Ops::fmadd(Ops::set1(-0.5f), z, Ops::set1(1.0f)));
+
+            // Swap in odd quadrants, and negate in the lower half plane
+            Vec swap = Ops::icmpeq(Ops::iand(j, Ops::iset1(2)), Ops::iset1(2));
+            Vec sinSign = Ops::icast(Ops::islli29(Ops::iand(j, Ops::iset1(4))));
+            Vec cosSign = Ops::icast(Ops::islli29(Ops::iand(Ops::iadd(j, Ops::iset1(2)),
+                                                            Ops::iset1(4))));
+            *outSin = Ops::bxor(Ops::blend(swap, sinPoly, cosPoly), sinSign);
+            *outCos = Ops::bxor(Ops::blend(swap, cosPoly, sinPoly), cosSign);
+        }
+
+    public:
+        // Returns false if any argument is out of range of the vector path
+        static inline bool calc(Vec x, Vec *outC, Vec *outS)
+        {
+            const Vec signMask = Ops::set1(-0.0f);
+            Vec sign = Ops::band(x, signMask);
+            Vec xMag = Ops::bandnot(signMask, x);
+            Vec x2 = Ops::mul(xMag, xMag);
+
+            // |x| < 2
+            Vec t = Ops::fmadd(Ops::mul(x2, x2), Ops::set1(1.0f/8), Ops::set1(-1.0f));
+            Vec c = Ops::mul(xMag, polynomial(Approx::smallC, t));
+            Vec s = Ops::mul(Ops::mul(xMag, x2), polynomial(Approx::smallS, t));
+
+            Vec small = Ops::cmplt(xMag, Ops::set1(2.0f));
+            if (!Ops::all(small)) {
+                if (!Ops::all(Ops::cmplt(x2, Ops::set1(maxSinCosArg))))
+                    return false;
+
+                Vec inv = Ops::div(Ops::set1(1.0f), xMag);
+                // 2 <= |x| < 4
+                Vec t4 = Ops::fmadd(inv, Ops::set1(8.0f), Ops::set1(-3.0f));
+                Vec f4 = polynomial(Approx::midF4, t4);
+                Vec g4 = polynomial(Approx::midG4, t4);
+                // 4 <= |x| < 8
+                Vec t8 = Ops::fmadd(inv, Ops::set1(16.0f), Ops::set1(-3.0f));
+                Vec f8 = polynomial(Approx::midF8, t8);
+                Vec g8 = polynomial(Approx::midG8, t8);
+                // 8 <= |x|
+                Vec v = Ops::mul(inv, inv);
+                v = Ops::mul(v, v);
+                Vec f = polynomial(Approx::asymptoticF, v);
+                Vec g = polynomial(Approx::asymptoticG, v);
+
+                Vec below8 = Ops::cmplt(xMag, Ops::set1(8.0f));
+                Vec below4 = Ops::cmplt(xMag, Ops::set1(4.0f));
+                f = Ops::blend(below4, Ops::blend(below8, f, f8), f4);
+                g = Ops::blend(below4, Ops::blend(below8, g, g8), g4);
+                f = Ops::mul(f, inv);
+                g = Ops::mul(g, Ops::mul(inv, Ops::mul(inv, inv)));
+
+                Vec sin, cos;
+                sincos(x2, &sin, &cos);
+                const Vec limit = Ops::set1(0.62665706865775012560394f);
+                Vec largeC = Ops::sub(Ops::fmadd(f, sin, limit), Ops::mul(g, cos));
+                Vec largeS = Ops::sub(Ops::sub(limit, Ops::mul(g, sin)), Ops::mul(f, cos));
+
+                c = Ops::blend(small, largeC, c);
+                s = Ops::blend(small, largeS, s);
+            }
+
+            // Both are odd functions
+            *outC = Ops::bxor(c, sign);
+            *outS = Ops::bxor(s, sign);
+            return true;
+        }
+
+        static void batch(const float *x, maths::Vector<2, float> *out, size_t n)
+        {
+            size_t i = 0;
+            for (; i + Ops::width <= n; i += Ops::width) {
+                Vec c, s;
+                if (calc(Ops::load(x + i), &c, &s)) {
+                    Ops::storeInterleaved((float *)(out + i), c, s);
+                } else {
+                    for (unsigned int j = 0; j < Ops::width; ++j)
+                        out[i + j] = fresnel(x[i + j]);
+                }
+            }
+            // Pad the remainder out to a whole vector, as short batches
+            // such as those of ClothoidPacket would otherwise all be scalar
+            if (i < n) {
+                float padded[Ops::width] = {};
+                maths::Vector<2, float> results[Ops::width];
+                for (size_t j = i; j < n; ++j)
+                    padded[j - i] = x[j];
+                Vec c, s;
+                if (calc(Ops::load(padded), &c, &s)) {
+                    Ops::storeInterleaved((float *)results, c, s);
+                    for (size_t j = i; j < n; ++j)
+                        out[j] = results[j - i];
+                } else {
+                    for (size_t j = i; j < n; ++j)
+                        out[j] = fresnel(x[j]);
+                }
+            }
+        }
+    };
+}
+
+#endif // TRAINS_FRESNEL_BATCH_H
@@ -0,0 +1,55 @@
+#include "FresnelBatch.h"
+
+#if defined(__i386) || defined(__x86_64)
+
+#include <immintrin.h>
+
+namespace Fresnel {
+    // AVX2 operations for BatchKernel
+    struct OpsAVX2 {
+        typedef __m256 Vec;
+        typedef __m256i IVec;
+        enum { width = 8 };
+
+        static inline Vec load(const float *p) { return _mm256_loadu_ps(p); }
+        static inline void storeInterleaved(float *p, Vec a, Vec b)
+        {
+            // unpack works within 128 bit lanes
+            Vec lo = _mm256_unpacklo_ps(a, b);
+            Vec hi = _mm256_unpackhi_ps(a, b);
+            _mm256_storeu_ps(p, _mm256_permute2f128_ps(lo, hi, 0x20));
+            _mm256_storeu_ps(p + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+        }
+
+        static inline Vec set1(float a) { return _mm256_set1_ps(a); }
+        static inline Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+        static inline Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+        static inline Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+        static inline Vec div(Vec a, Vec b) { return _mm256_div_ps(a, b); }
+        static inline Vec fmadd(Vec a, Vec b, Vec c) { return _mm256_fmadd_ps(a, b, c); }
+
+        static inline Vec band(Vec a, Vec b) { return _mm256_and_ps(a, b); }
+        static inline Vec bandnot(Vec a, Vec b) { return _mm256_andnot_ps(a, b); }
+        static inline Vec bxor(Vec a, Vec b) { return _mm256_xor_ps(a, b); }
+        // mask ? b : a
+        static inline Vec blend(Vec mask, Vec a, Vec b) { return _mm256_blendv_ps(a, b, mask); }
+        static inline Vec cmplt(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        static inline bool all(Vec mask) { return _mm256_movemask_ps(mask) == 0xff; }
+
+        static inline IVec iset1(int a) { return _mm256_set1_epi32(a); }
+        static inline IVec iadd(IVec a, IVec b) { return _mm256_add_epi32(a, b); }
+        static inline IVec iand(IVec a, IVec b) { return _mm256_and_si256(a, b); }
+        static inline IVec islli29(IVec a) { return _mm256_slli_epi32(a, 29); }
+        static inline Vec icmpeq(IVec a, IVec b) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+        static inline Vec icast(IVec a) { return _mm256_castsi256_ps(a); }
+        static inline IVec cvttps(Vec a) { return _mm256_cvttps_epi32(a); }
+        static inline Vec cvtepi32(IVec a) { return _mm256_cvtepi32_ps(a); }
+    };
+
+    void batchAVX2(const float *x, maths::Vector<2, float> *out, size_t n)
+    {
+        BatchKernel<OpsAVX2>::batch(x, out, n);
+    }
+}
+
+#endif
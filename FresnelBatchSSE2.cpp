@@ -0,0 +1,55 @@
+#include "FresnelBatch.h"
+
+#if defined(__i386) || defined(__x86_64)
+
+#include <emmintrin.h>
+
+namespace Fresnel {
+    // SSE2 operations for BatchKernel
+    struct OpsSSE2 {
+        typedef __m128 Vec;
+        typedef __m128i IVec;
+        enum { width = 4 };
+
+        static inline Vec load(const float *p) { return _mm_loadu_ps(p); }
+        static inline void storeInterleaved(float *p, Vec a, Vec b)
+        {
+            _mm_storeu_ps(p, _mm_unpacklo_ps(a, b));
+            _mm_storeu_ps(p + 4, _mm_unpackhi_ps(a, b));
+        }
+
+        static inline Vec set1(float a) { return _mm_set1_ps(a); }
+        static inline Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+        static inline Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+        static inline Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+        static inline Vec div(Vec a, Vec b) { return _mm_div_ps(a, b); }
+        static inline Vec fmadd(Vec a, Vec b, Vec c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+        static inline Vec band(Vec a, Vec b) { return _mm_and_ps(a, b); }
+        static inline Vec bandnot(Vec a, Vec b) { return _mm_andnot_ps(a, b); }
+        static inline Vec bxor(Vec a, Vec b) { return _mm_xor_ps(a, b); }
+        // mask ? b : a
+        static inline Vec blend(Vec mask, Vec a, Vec b)
+        {
+            return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+        }
+        static inline Vec cmplt(Vec a, Vec b) { return _mm_cmplt_ps(a, b); }
+        static inline bool all(Vec mask) { return _mm_movemask_ps(mask) == 0xf; }
+
+        static inline IVec iset1(int a) { return _mm_set1_epi32(a); }
+        static inline IVec iadd(IVec a, IVec b) { return _mm_add_epi32(a, b); }
+        static inline IVec iand(IVec a, IVec b) { return _mm_and_si128(a, b); }
+        static inline IVec islli29(IVec a) { return _mm_slli_epi32(a, 29); }
+        static inline Vec icmpeq(IVec a, IVec b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+        static inline Vec icast(IVec a) { return _mm_castsi128_ps(a); }
+        static inline IVec cvttps(Vec a) { return _mm_cvttps_epi32(a); }
+        static inline Vec cvtepi32(IVec a) { return _mm_cvtepi32_ps(a); }
+    };
+
+    void batchSSE2(const float *x, maths::Vector<2, float> *out, size_t n)
+    {
+        BatchKernel<OpsSSE2>::batch(x, out, n);
+    }
+}
+
+#endif
@@ -0,0 +1,152 @@
+#include "InterpolationCache.h"
+
+#include <cmath>
+
+// Cell sizes of relative geometry
+static constexpr float offsetStep = 5e-2f;
+static constexpr float directionStep = 1e-3f;
+static constexpr float curvatureStep = 1e-8f;
+// How far relative geometry may differ from an entry's to reuse it, which
+// must be under half a cell. Rigidly moving sections tens of kilometres from
+// the origin changes their offsets by up to 9mm and directions by 1e-5.
+static constexpr float offsetTolerance = 1e-2f;
+static constexpr float directionTolerance = 1e-4f;
+
+// Find the cell of a value, and the neighbouring cell if the value is within
+// tolerance of its edge, returning whether there is one
+static bool quantise(float value, float step, float tolerance,
+                     int32_t *outCell, int32_t *outNeighbour)
+{
+    float scaled = value / step;
+    *outCell = lroundf(scaled);
+    float fraction = scaled - *outCell;
+    float margin = 0.5f - tolerance / step;
+    if (fraction > margin) {
+        *outNeighbour = *outCell + 1;
+        return true;
+    }
+    if (fraction < -margin) {
+        *outNeighbour = *outCell - 1;
+        return true;
+    }
+    return false;
+}
+
+bool InterpolationCache::Key::operator == (const Key &other) const
+{
+    return offset[0] == other.offset[0] && offset[1] == other.offset[1] &&
+           direction == other.direction &&
+           curvature[0] == other.curvature[0] && curvature[1] == other.curvature[1] &&
+           numTracks[0] == other.numTracks[0] && numTracks[1] == other.numTracks[1] &&
+           spec == other.spec &&
+           lastDir[0] == other.lastDir[0] && lastDir[1] == other.lastDir[1];
+}
+
+size_t InterpolationCache::KeyHash::operator () (const Key &key) const
+{
+    size_t hash = std::hash<const TrackSpec *>()(key.spec);
+    auto combine = [&hash](size_t value) {
+        hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    };
+    combine(key.offset[0]);
+    combine(key.offset[1]);
+    combine(key.direction);
+    combine(key.curvature[0]);
+    combine(key.curvature[1]);
+    combine(key.numTracks[0] | key.numTracks[1] << 16);
+    combine((key.lastDir[0] + 1) | (key.lastDir[1] + 1) << 4);
+    return hash;
+}
+
+InterpolationCache::InterpolationCache()
+: stats{0, 0}
+{
+}
+
+InterpolationCache::Key InterpolationCache::makeKey(const TrackNode::Reference &start,
+                                                    const TrackNode::Reference &end,
+                                                    const TrackSpec *spec,
+                                                    int lastDir1, int lastDir2)
+{
+    const float startDirection = start.getDirection();
+    Vec2f offset = (Vec2f)end.getMidpoint() - (Vec2f)start.getMidpoint();
+    Vec2f forwardVec;
+    sincosf(startDirection, &forwardVec[1], &forwardVec[0]);
+    Vec2f leftVec(-forwardVec[1], forwardVec[0]);
+    float direction = remainderf(end.getDirection() - startDirection, M_PI*2);
+
+    Key key;
+    key.geometry.offset[0] = offset * forwardVec;
+    key.geometry.offset[1] = offset * leftVec;
+    key.geometry.direction = direction;
+    key.offset[0] = lroundf(key.geometry.offset[0] / offsetStep);
+    key.offset[1] = lroundf(key.geometry.offset[1] / offsetStep);
+    key.direction = lroundf(direction / directionStep);
+    key.curvature[0] = lroundf(start.getCurvature() / curvatureStep);
+    key.curvature[1] = lroundf(end.getCurvature() / curvatureStep);
+    key.numTracks[0] = start.getNumTracks();
+    key.numTracks[1] = end.getNumTracks();
+    key.spec = spec;
+    key.lastDir[0] = lastDir1;
+    key.lastDir[1] = lastDir2;
+    return key;
+}
+
+bool InterpolationCache::lookup(const Key &key, Result *outResult)
+{
+    // Cells to try in each dimension of relative geometry
+    const Geometry &geometry = key.geometry;
+    int32_t cells[3][2];
+    unsigned int numCells[3];
+    numCells[0] = 1 + quantise(geometry.offset[0], offsetStep, offsetTolerance,
+                               &cells[0][0], &cells[0][1]);
+    numCells[1] = 1 + quantise(geometry.offset[1], offsetStep, offsetTolerance,
+                               &cells[1][0], &cells[1][1]);
+    numCells[2] = 1 + quantise(geometry.direction, directionStep, directionTolerance,
+                               &cells[2][0], &cells[2][1]);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Key probe = key;
+    for (unsigned int x = 0; x < numCells[0]; ++x) {
+        probe.offset[0] = cells[0][x];
+        for (unsigned int y = 0; y < numCells[1]; ++y) {
+            probe.offset[1] = cells[1][y];
+            for (unsigned int d = 0; d < numCells[2]; ++d) {
+                probe.direction = cells[2][d];
+                auto it = entries.find(probe);
+                if (it == entries.end())
+                    continue;
+                const Geometry &found = it->second.geometry;
+                if (fabsf(found.offset[0] - geometry.offset[0]) <= offsetTolerance &&
+                    fabsf(found.offset[1] - geometry.offset[1]) <= offsetTolerance &&
+                    fabsf(found.direction - geometry.direction) <= directionTolerance) {
+                    ++stats.hits;
+                    *outResult = it->second.result;
+                    return true;
+                }
+            }
+        }
+    }
+    ++stats.misses;
+    return false;
+}
+
+void InterpolationCache::insert(const Key &key, const Result &result)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.size() >= maxEntries)
+        entries.clear();
+    entries[key] = { key.geometry, result };
+}
+
+void InterpolationCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+}
+
+InterpolationCache::Stats InterpolationCache::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
@@ -0,0 +1,93 @@
+#ifndef TRAINS_INTERPOLATION_CACHE_H
+#define TRAINS_INTERPOLATION_CACHE_H
+
+#include "TrackNode.h"
+#include "TrackSectionParams.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+class TrackSpec;
+
+/*
+ * Memoises track section shapes by the geometry of the end node relative to
+ * the start node, so sections moved or rotated rigidly don't need solving
+ * again. Node positions are floats, so moving a section far from the origin
+ * perturbs its relative geometry by several millimetres. Entries are found
+ * by coarse cells of relative geometry, trying neighbouring cells when near
+ * an edge, and only reused within a tolerance of the exact geometry, so a
+ * reused shape may miss the end node by up to a centimetre. Safe to use
+ * from multiple threads.
+ */
+class InterpolationCache
+{
+public:
+    // End node offset and direction in the start node's frame
+    struct Geometry {
+        float offset[2];
+        float direction;
+    };
+
+    struct Key {
+        // Cells of the end node offset and direction in the start node's frame
+        int32_t offset[2];
+        int32_t direction;
+        // Quantised curvatures of the start node and reversed end node
+        int32_t curvature[2];
+        unsigned int numTracks[2];
+        const TrackSpec *spec;
+        // Previously chosen directions, which bias the choice
+        int lastDir[2];
+        // Exact relative geometry, not compared, but checked against that of
+        // entries found in the cells
+        Geometry geometry;
+
+        bool operator == (const Key &other) const;
+    };
+
+    struct Result {
+        TrackSectionParams params;
+        // Chosen curve directions
+        int dir1, dir2;
+    };
+
+    struct Stats {
+        unsigned long hits;
+        unsigned long misses;
+    };
+
+private:
+    struct KeyHash {
+        size_t operator () (const Key &key) const;
+    };
+
+    struct Entry {
+        Geometry geometry;
+        Result result;
+    };
+
+    // Entries are discarded wholesale beyond this many
+    static constexpr size_t maxEntries = 1 << 16;
+
+    mutable std::mutex mutex;
+    std::unordered_map<Key, Entry, KeyHash> entries;
+    Stats stats;
+
+public:
+    InterpolationCache();
+
+    static Key makeKey(const TrackNode::Reference &start,
+                       const TrackNode::Reference &end,
+                       const TrackSpec *spec, int lastDir1, int lastDir2);
+
+    // Find a cached result, counting hits and misses
+    bool lookup(const Key &key, Result *outResult);
+    void insert(const Key &key, const Result &result);
+    void clear();
+
+    Stats getStats() const;
+};
+
+#endif // TRAINS_INTERPOLATION_CACHE_H
@@ -0,0 +1,186 @@
+#include "NodeIndex.h"
+#include "TrackNode.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+// Cell coordinates are clamped to this, so unbounded boxes scan every cell
+static constexpr float maxCellCoord = 1e9f;
+
+NodeIndex::NodeIndex(float newCellSize)
+: cellSize(newCellSize),
+  minZ(std::numeric_limits<float>::infinity()),
+  maxZ(-std::numeric_limits<float>::infinity())
+{
+}
+
+void NodeIndex::insert(TrackNode *node)
+{
+    Vec3f midpoint = node->getMidpoint();
+    uint64_t key = cellKey(cellCoord(midpoint[0]), cellCoord(midpoint[1]));
+    cells[key].push_back({node, midpoint});
+    nodeCells[node] = key;
+    // Heights are only ever widened, which is safe for line queries
+    minZ = std::min(minZ, midpoint[2]);
+    maxZ = std::max(maxZ, midpoint[2]);
+}
+
+void NodeIndex::update(TrackNode *node)
+{
+    auto it = nodeCells.find(node);
+    if (it == nodeCells.end()) {
+        insert(node);
+        return;
+    }
+
+    Vec3f midpoint = node->getMidpoint();
+    uint64_t key = cellKey(cellCoord(midpoint[0]), cellCoord(midpoint[1]));
+    if (key == it->second) {
+        for (Entry &entry: cells[key]) {
+            if (entry.node == node) {
+                entry.midpoint = midpoint;
+                break;
+            }
+        }
+        minZ = std::min(minZ, midpoint[2]);
+        maxZ = std::max(maxZ, midpoint[2]);
+        return;
+    }
+    remove(node);
+    insert(node);
+}
+
+void NodeIndex::remove(TrackNode *node)
+{
+    auto it = nodeCells.find(node);
+    if (it == nodeCells.end())
+        return;
+    auto cellIt = cells.find(it->second);
+    Cell &cell = cellIt->second;
+    for (Entry &entry: cell) {
+        if (entry.node == node) {
+            entry = cell.back();
+            cell.pop_back();
+            break;
+        }
+    }
+    if (cell.empty())
+        cells.erase(cellIt);
+    nodeCells.erase(it);
+}
+
+void NodeIndex::clear()
+{
+    cells.clear();
+    nodeCells.clear();
+    minZ = std::numeric_limits<float>::infinity();
+    maxZ = -std::numeric_limits<float>::infinity();
+}
+
+template <typename F>
+void NodeIndex::forEachInBox(const Vec2f &min, const Vec2f &max, F func) const
+{
+    auto clampedCoord = [this](float coord) {
+        float scaled = floorf(coord / cellSize);
+        return (int64_t)std::min(std::max(scaled, -maxCellCoord), maxCellCoord);
+    };
+    int64_t x0 = clampedCoord(min[0]), x1 = clampedCoord(max[0]);
+    int64_t y0 = clampedCoord(min[1]), y1 = clampedCoord(max[1]);
+
+    // Large boxes are quicker to check against each occupied cell
+    if ((x1 - x0 + 1) * (y1 - y0 + 1) > (int64_t)cells.size()) {
+        for (const auto &cell: cells) {
+            int64_t x = (int32_t)(cell.first >> 32);
+            int64_t y = (int32_t)(uint32_t)cell.first;
+            if (x >= x0 && x <= x1 && y >= y0 && y <= y1) {
+                for (const Entry &entry: cell.second)
+                    func(entry);
+            }
+        }
+        return;
+    }
+
+    for (int64_t x = x0; x <= x1; ++x) {
+        for (int64_t y = y0; y <= y1; ++y) {
+            auto it = cells.find(cellKey(x, y));
+            if (it != cells.end()) {
+                for (const Entry &entry: it->second)
+                    func(entry);
+            }
+        }
+    }
+}
+
+void NodeIndex::findNearest(const Vec2f &point, unsigned int k,
+                            std::vector<TrackNode *> *outNodes) const
+{
+    outNodes->clear();
+    if (!k || nodeCells.empty())
+        return;
+
+    // Search ever larger boxes until the kth nearest is within the circle
+    // inside the box, so nothing outside can be nearer
+    std::vector<std::pair<float, TrackNode *>> found;
+    for (float radius = cellSize; ; radius *= 2) {
+        found.clear();
+        forEachInBox(point - Vec2f(radius), point + Vec2f(radius), [&](const Entry &entry) {
+            found.push_back({((Vec2f)entry.midpoint - point).sqr(), entry.node});
+        });
+        size_t n = std::min<size_t>(k, found.size());
+        std::partial_sort(found.begin(), found.begin() + n, found.end());
+        if (found.size() == nodeCells.size() ||
+                (found.size() >= k && found[k - 1].first <= radius * radius)) {
+            found.resize(n);
+            break;
+        }
+    }
+    for (const auto &candidate: found)
+        outNodes->push_back(candidate.second);
+}
+
+void NodeIndex::findWithinRadius(const Vec2f &point, float radius,
+                                 std::vector<TrackNode *> *outNodes) const
+{
+    outNodes->clear();
+    const float radiusSqr = radius * radius;
+    forEachInBox(point - Vec2f(radius), point + Vec2f(radius), [&](const Entry &entry) {
+        if (((Vec2f)entry.midpoint - point).sqr() <= radiusSqr)
+            outNodes->push_back(entry.node);
+    });
+}
+
+void NodeIndex::findNearLine(const LineUnit3f &line, float range, unsigned int k,
+                             std::vector<TrackNode *> *outNodes) const
+{
+    outNodes->clear();
+    if (!k || nodeCells.empty())
+        return;
+
+    // Any point within range of the line is within range in the plane of the
+    // part of the line between the extreme heights, widened by range
+    Vec2f min(-std::numeric_limits<float>::infinity());
+    Vec2f max(std::numeric_limits<float>::infinity());
+    if (fabs(line.norm[2]) > 1e-3f) {
+        Vec3f low = line * ((minZ - range - line.start[2]) / line.norm[2]);
+        Vec3f high = line * ((maxZ + range - line.start[2]) / line.norm[2]);
+        for (int i = 0; i < 2; ++i) {
+            min[i] = std::min(low[i], high[i]) - range;
+            max[i] = std::max(low[i], high[i]) + range;
+        }
+    }
+
+    const float rangeSqr = range * range;
+    std::vector<std::pair<float, TrackNode *>> found;
+    forEachInBox(min, max, [&](const Entry &entry) {
+        Vec3f closest = line * line.closestPoint(entry.midpoint);
+        float distanceSqr = (closest - entry.midpoint).sqr();
+        if (distanceSqr < rangeSqr)
+            found.push_back({distanceSqr, entry.node});
+    });
+    size_t n = std::min<size_t>(k, found.size());
+    std::partial_sort(found.begin(), found.begin() + n, found.end());
+    for (size_t i = 0; i < n; ++i)
+        outNodes->push_back(found[i].second);
+}
@@ -0,0 +1,73 @@
+#ifndef TRAINS_NODE_INDEX_H
+#define TRAINS_NODE_INDEX_H
+
+#include "Vector.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class TrackNode;
+
+/*
+ * Hashed uniform grid of track node midpoints, for picking nodes without
+ * visiting every one. Only occupied cells are stored, so the layout can be
+ * any size. Midpoints are kept in the cells so queries don't need to
+ * recalculate them.
+ */
+class NodeIndex
+{
+private:
+    struct Entry {
+        TrackNode *node;
+        Vec3f midpoint;
+    };
+    typedef std::vector<Entry> Cell;
+
+    float cellSize;
+    std::unordered_map<uint64_t, Cell> cells;
+    // Cell of each node
+    std::unordered_map<const TrackNode *, uint64_t> nodeCells;
+    // Range of midpoint heights, which bounds where a line can come close
+    float minZ, maxZ;
+
+public:
+    explicit NodeIndex(float newCellSize = 64.0f);
+
+    void insert(TrackNode *node);
+    // Update a node after its midpoint changes
+    void update(TrackNode *node);
+    void remove(TrackNode *node);
+    void clear();
+
+    size_t size() const
+    {
+        return nodeCells.size();
+    }
+
+    // Up to k nodes closest to point in the plane, nearest first
+    void findNearest(const Vec2f &point, unsigned int k,
+                     std::vector<TrackNode *> *outNodes) const;
+    // Nodes within radius of point in the plane, in no particular order
+    void findWithinRadius(const Vec2f &point, float radius,
+                          std::vector<TrackNode *> *outNodes) const;
+    // Up to k nodes within range of line, nearest to it first
+    void findNearLine(const LineUnit3f &line, float range, unsigned int k,
+                      std::vector<TrackNode *> *outNodes) const;
+
+private:
+    int cellCoord(float coord) const
+    {
+        return (int)floorf(coord / cellSize);
+    }
+    static uint64_t cellKey(int x, int y)
+    {
+        return (uint64_t)(uint32_t)x << 32 | (uint32_t)y;
+    }
+
+    // Call func(entry) for each entry in cells overlapping a box
+    template <typename F>
+    void forEachInBox(const Vec2f &min, const Vec2f &max, F func) const;
+};
+
+#endif // TRAINS_NODE_INDEX_H
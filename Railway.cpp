@@ -1,40 +1,253 @@
 #include "Railway.h"
+#include "ThreadPool.h"
 #include "TrackNode.h"
+#include "TrackSection.h"
+#include "TrackSectionStrategy.h"
 #include "Train.h"
 
-void Railway::addNode(TrackNode *node)
+#include <algorithm>
+
+// Fewer dirty sections than this are interpolated on the calling thread
+static constexpr size_t minParallelSections = 16;
+// Passes without changes while interactive before rough shapes are refined
+static constexpr unsigned int refineIdlePasses = 30;
+
+Railway::Railway()
+: interpolationStats{0, 0},
+  interpolationStrategies(TrackSectionStrategy::getDefaults()),
+  interpolationBudget(0),
+  interactive(false),
+  refining(false),
+  idlePasses(0),
+  numThreads(0)
+{
+}
+
+Railway::~Railway()
+{
+}
+
+NodeId Railway::addNode(TrackNode *node)
+{
+    NodeId id = nodes.insert(node);
+    node->setRailway(this, id);
+    nodeIndex.insert(node);
+    return id;
+}
+
+SectionId Railway::addSection(TrackSection *section)
+{
+    SectionId id = sections.insert(section);
+    section->setRailway(this, id);
+    sectionTree.insert(section);
+    return id;
+}
+
+TrainId Railway::addTrain(Train *train)
+{
+    TrainId id = trains.insert(train);
+    train->setId(id);
+    return id;
+}
+
+bool Railway::removeNode(NodeId id)
+{
+    TrackNode *node = nodes.get(id);
+    if (!node)
+        return false;
+    // Copied, as removing sections detaches them from the node
+    std::vector<TrackSection *> nodeSections(node->getSections().begin(),
+                                             node->getSections().end());
+    for (TrackSection *section: nodeSections)
+        removeSection(section->getId());
+    nodeIndex.remove(node);
+    return nodes.remove(id);
+}
+
+bool Railway::removeSection(SectionId id)
+{
+    TrackSection *section = sections.get(id);
+    if (!section)
+        return false;
+
+    std::vector<TrainId> trainsOnSection;
+    for (const Train *train: trains)
+        if (train->isOnSection(section))
+            trainsOnSection.push_back(train->getId());
+    for (TrainId trainId: trainsOnSection)
+        removeTrain(trainId);
+
+    section->start().getNode()->removeTrackSection(section);
+    section->end().getNode()->removeTrackSection(section);
+    if (section->isInterpolationPending())
+        dirtySections.erase(std::find(dirtySections.begin(), dirtySections.end(), section));
+    if (section->isRoughListed())
+        roughSections.erase(std::find(roughSections.begin(), roughSections.end(), section));
+    sectionTree.remove(section);
+    return sections.remove(id);
+}
+
+bool Railway::removeTrain(TrainId id)
 {
-    nodes.push_back(node);
+    return trains.remove(id);
 }
 
-void Railway::addSection(TrackSection *section)
+void Railway::findSectionsInBox(const Box2f &box, std::vector<TrackSection *> *outSections) const
 {
-    sections.push_back(section);
+    sectionTree.findInBox(box, outSections);
 }
 
-void Railway::addTrain(Train *train)
+void Railway::findSectionsWithinRadius(const Vec2f &point, float radius,
+                                       std::vector<TrackSection *> *outSections) const
 {
-    trains.push_back(train);
+    sectionTree.findWithinRadius(point, radius, outSections);
+}
+
+void Railway::findSectionsOnRay(const Vec2f &origin, const Vec2f &direction, float length,
+                                std::vector<TrackSection *> *outSections) const
+{
+    sectionTree.findOnRay(origin, direction, length, outSections);
+}
+
+TrackSection *Railway::findClosestTrack(const Vec2f &point, float maxSeparation,
+                                        int *outTrackIndex, float *outDistance) const
+{
+    return sectionTree.findClosestTrack(point, maxSeparation, outTrackIndex, outDistance);
+}
+
+void Railway::notifyNodeMoved(TrackNode *node)
+{
+    nodeIndex.update(node);
 }
 
 // Find nearest node
 TrackNode *Railway::findClosestNode(const LineUnit3f &line, float range)
 {
-    TrackNode *best = nullptr;
-    float bestRangeSqr = range * range;
-    for (TrackNode *node: nodes) {
-        Vec3f closest = line * line.closestPoint(node->getMidpoint());
-        float distanceSqr = (closest - node->getMidpoint()).sqr();
-        if (distanceSqr < bestRangeSqr) {
-            best = node;
-            bestRangeSqr = distanceSqr;
+    std::vector<TrackNode *> found;
+    nodeIndex.findNearLine(line, range, 1, &found);
+    return found.empty() ? nullptr : found[0];
+}
+
+void Railway::findClosestNodes(const LineUnit3f &line, float range, unsigned int k,
+                               std::vector<TrackNode *> *outNodes) const
+{
+    nodeIndex.findNearLine(line, range, k, outNodes);
+}
+
+void Railway::findNearestNodes(const Vec2f &point, unsigned int k,
+                               std::vector<TrackNode *> *outNodes) const
+{
+    nodeIndex.findNearest(point, k, outNodes);
+}
+
+void Railway::findNodesWithinRadius(const Vec2f &point, float radius,
+                                    std::vector<TrackNode *> *outNodes) const
+{
+    nodeIndex.findWithinRadius(point, radius, outNodes);
+}
+
+void Railway::markDirty(TrackSection *section)
+{
+    ++interpolationStats.requested;
+    if (!section->isInterpolationPending()) {
+        section->setInterpolationPending(true);
+        dirtySections.push_back(section);
+    }
+}
+
+void Railway::interpolateDirty()
+{
+    if (!dirtySections.empty()) {
+        idlePasses = 0;
+        interpolatePending();
+        return;
+    }
+
+    // Nothing changed, so refine rough shapes once input settles, waiting a
+    // little while nodes are still being dragged
+    if (roughSections.empty())
+        return;
+    if (interactive && ++idlePasses < refineIdlePasses)
+        return;
+    for (TrackSection *section: roughSections) {
+        section->setRoughListed(false);
+        if (section->isRough()) {
+            section->setInterpolationPending(true);
+            dirtySections.push_back(section);
         }
     }
-    return best;
+    roughSections.clear();
+    refining = true;
+    interpolatePending();
+    refining = false;
+}
+
+void Railway::interpolatePending()
+{
+    if (dirtySections.empty())
+        return;
+
+    // Sections only depend on their own nodes, so the result doesn't depend
+    // on the order or thread they're interpolated on
+    auto interpolateSection = [this](size_t i) {
+        dirtySections[i]->interpolate();
+    };
+    if (dirtySections.size() >= minParallelSections && numThreads != 1) {
+        if (!threadPool)
+            threadPool.reset(new ThreadPool(numThreads));
+        threadPool->parallelFor(dirtySections.size(), interpolateSection);
+    } else {
+        for (size_t i = 0; i < dirtySections.size(); ++i)
+            interpolateSection(i);
+    }
+
+    interpolationStats.performed += dirtySections.size();
+    for (TrackSection *section: dirtySections) {
+        section->setInterpolationPending(false);
+        if (section->isRough() && !section->isRoughListed()) {
+            section->setRoughListed(true);
+            roughSections.push_back(section);
+        }
+        sectionTree.update(section);
+    }
+    dirtySections.clear();
+}
+
+void Railway::interpolateAll()
+{
+    for (TrackSection *section: sections) {
+        if (!section->isInterpolationPending()) {
+            section->setInterpolationPending(true);
+            dirtySections.push_back(section);
+        }
+    }
+    interpolateDirty();
+}
+
+void Railway::setNumThreads(unsigned int newNumThreads)
+{
+    if (newNumThreads != numThreads) {
+        numThreads = newNumThreads;
+        threadPool.reset();
+    }
+}
+
+void Railway::setInterpolationStrategies(const std::vector<const TrackSectionStrategy *> &strategies)
+{
+    interpolationStrategies = strategies;
+    // Cached shapes came from the old strategies
+    interpolationCache.clear();
+}
+
+void Railway::setInteractive(bool newInteractive)
+{
+    // Drafts are refined by the next interpolateDirty() without changes
+    interactive = newInteractive;
 }
 
 void Railway::advance(float dt)
 {
+    interpolateDirty();
     for (Train *train: trains)
         train->drive(dt);
 }
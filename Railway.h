@@ -1,33 +1,187 @@
 #ifndef TRAINS_RAILWAY_H
 #define TRAINS_RAILWAY_H
 
+#include "InterpolationCache.h"
+#include "NodeIndex.h"
 #include "Renderable.h"
+#include "SectionTree.h"
+#include "SlotMap.h"
 #include "Vector.h"
 
-#include <list>
+#include <memory>
+#include <vector>
 
 class TrackNode;
+class ThreadPool;
 class TrackSection;
+class TrackSectionStrategy;
 class Train;
 
+typedef SlotId<TrackSection> SectionId;
+typedef SlotId<Train> TrainId;
+
 // Track sections
 // Signalling
 // etc
 class Railway : public Renderable
 {
 private:
-    // TODO use a more lookup-efficient data structure
-    std::list<TrackNode *> nodes;
-    std::list<TrackSection *> sections;
-    std::list<Train *> trains;
+    // Everything on the railway, owned by it
+    SlotMap<TrackNode> nodes;
+    // Node midpoints for picking and proximity queries
+    NodeIndex nodeIndex;
+    SlotMap<TrackSection> sections;
+    // Section bounds for range queries, refitted as sections are interpolated
+    SectionTree sectionTree;
+    SlotMap<Train> trains;
+
+public:
+    // Counts of section re-interpolation work
+    struct InterpolationStats {
+        // Times a section was changed
+        unsigned long requested;
+        // Times a section was actually interpolated
+        unsigned long performed;
+    };
+
+private:
+    // Sections whose nodes have changed since they were last interpolated,
+    // in the order they were changed
+    std::vector<TrackSection *> dirtySections;
+    // Sections left with rough shapes, to refine once input settles
+    std::vector<TrackSection *> roughSections;
+    InterpolationStats interpolationStats;
+    // Shapes of sections by relative node geometry
+    InterpolationCache interpolationCache;
+    // Algorithms for shaping sections, the shortest result being used
+    std::vector<const TrackSectionStrategy *> interpolationStrategies;
+    // Seconds each section may spend on further strategies once one has
+    // succeeded, or 0 for unlimited
+    float interpolationBudget;
+    // Whether nodes are being dragged, so sections may be drafted
+    bool interactive;
+    // Whether rough shapes are being refined, without drafts or budget
+    bool refining;
+    // Passes of interpolateDirty() since the last with changes
+    unsigned int idlePasses;
+
+    // Threads for interpolating many sections, created when first needed
+    std::unique_ptr<ThreadPool> threadPool;
+    unsigned int numThreads;
+
+    // Interpolate the dirty sections, listing any left rough
+    void interpolatePending();
 
 public:
-    void addNode(TrackNode *node);
-    void addSection(TrackSection *section);
-    void addTrain(Train *train);
+    Railway();
+    ~Railway();
+
+    // Take ownership of objects, returning handles to them
+    NodeId addNode(TrackNode *node);
+    SectionId addSection(TrackSection *section);
+    TrainId addTrain(Train *train);
+
+    // Find objects by handle, or nullptr if they have been removed
+    TrackNode *getNode(NodeId id) const
+    {
+        return nodes.get(id);
+    }
+    TrackSection *getSection(SectionId id) const
+    {
+        return sections.get(id);
+    }
+    Train *getTrain(TrainId id) const
+    {
+        return trains.get(id);
+    }
+
+    // Delete a node along with its sections
+    bool removeNode(NodeId id);
+    // Delete a section, detaching it from its nodes, along with any trains
+    // on it
+    bool removeSection(SectionId id);
+    bool removeTrain(TrainId id);
+
+    // Defer interpolation of a changed section until interpolateDirty()
+    void markDirty(TrackSection *section);
+    // Interpolate each changed section once, before using their shapes.
+    // Large batches are split between threads. Passes without changes
+    // refine rough shapes instead, right away unless interactive.
+    void interpolateDirty();
+    // Interpolate every section, such as after loading
+    void interpolateAll();
+
+    // Set the number of threads for interpolation, 0 for one per hardware
+    // thread (the default)
+    void setNumThreads(unsigned int newNumThreads);
+
+    const InterpolationStats &getInterpolationStats() const
+    {
+        return interpolationStats;
+    }
+    InterpolationCache &getInterpolationCache()
+    {
+        return interpolationCache;
+    }
+
+    // Replace the strategies, which must outlive the railway
+    void setInterpolationStrategies(const std::vector<const TrackSectionStrategy *> &strategies);
+    const std::vector<const TrackSectionStrategy *> &getInterpolationStrategies() const
+    {
+        return interpolationStrategies;
+    }
+    // Limit time spent on each section, such as while dragging nodes. The
+    // budget is only checked between strategies, which run one at a time, so
+    // a section may overrun it by as long as its slowest strategy takes.
+    void setInterpolationBudget(float seconds)
+    {
+        interpolationBudget = seconds;
+    }
+    float getInterpolationBudget() const
+    {
+        return interpolationBudget;
+    }
+    // Draft section shapes cheaply while nodes are being dragged, refining
+    // rough shapes once input settles
+    void setInteractive(bool newInteractive);
+    bool isInteractive() const
+    {
+        return interactive;
+    }
+    // Whether sections are being refined, so should be solved in full
+    bool isRefining() const
+    {
+        return refining;
+    }
+
+    // Find sections whose bounds intersect a box. Like the queries below,
+    // this uses section shapes as of the last interpolateDirty().
+    void findSectionsInBox(const Box2f &box, std::vector<TrackSection *> *outSections) const;
+    // Find sections with a track within radius of a point
+    void findSectionsWithinRadius(const Vec2f &point, float radius,
+                                  std::vector<TrackSection *> *outSections) const;
+    // Find sections whose bounds a ray on the ground passes through, nearest
+    // first
+    void findSectionsOnRay(const Vec2f &origin, const Vec2f &direction, float length,
+                           std::vector<TrackSection *> *outSections) const;
+    // Find the closest track to a point within maxSeparation, or nullptr
+    TrackSection *findClosestTrack(const Vec2f &point, float maxSeparation,
+                                   int *outTrackIndex, float *outDistance) const;
+
+    // Re-index a node after it moves
+    void notifyNodeMoved(TrackNode *node);
 
     // Find nearest node
     TrackNode *findClosestNode(const LineUnit3f &line, float range);
+    // Find up to k nodes within range of a line, nearest first
+    void findClosestNodes(const LineUnit3f &line, float range, unsigned int k,
+                          std::vector<TrackNode *> *outNodes) const;
+    // Find up to k nodes nearest to a point on the ground, nearest first
+    void findNearestNodes(const Vec2f &point, unsigned int k,
+                          std::vector<TrackNode *> *outNodes) const;
+    // Find nodes within radius of a point on the ground
+    void findNodesWithinRadius(const Vec2f &point, float radius,
+                               std::vector<TrackNode *> *outNodes) const;
 
     void advance(float dt);
 
@@ -7,6 +7,8 @@
 
 void Railway::renderGL(RendererOpenGL *renderer)
 {
+    interpolateDirty();
+
     glLineWidth(2);
     glPointSize(4);
     for (TrackSection *section: sections) {
@@ -13,6 +13,10 @@ class RendererOpenGL;
 class Renderable
 {
 public:
+    virtual ~Renderable()
+    {
+    }
+
     RENDERABLE_GENERIC();
     RENDERABLE_GL();
 };
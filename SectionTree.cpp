@@ -0,0 +1,379 @@
+#include "SectionTree.h"
+#include "TrackSection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <utility>
+
+SectionTree::SectionTree(float newMargin)
+: root(none),
+  freeNodes(none),
+  margin(newMargin)
+{
+}
+
+void SectionTree::insert(TrackSection *section)
+{
+    int leaf = allocateNode();
+    treeNodes[leaf].section = section;
+    treeNodes[leaf].bounds = sectionBounds(section);
+    treeNodes[leaf].bounds.expand(margin);
+    leaves[section] = leaf;
+    insertLeaf(leaf);
+}
+
+void SectionTree::update(TrackSection *section)
+{
+    auto it = leaves.find(section);
+    if (it == leaves.end()) {
+        insert(section);
+        return;
+    }
+
+    // Small changes stay within the margin
+    int leaf = it->second;
+    Box2f bounds = sectionBounds(section);
+    if (treeNodes[leaf].bounds.contains(bounds))
+        return;
+    removeLeaf(leaf);
+    bounds.expand(margin);
+    treeNodes[leaf].bounds = bounds;
+    insertLeaf(leaf);
+}
+
+void SectionTree::remove(TrackSection *section)
+{
+    auto it = leaves.find(section);
+    if (it == leaves.end())
+        return;
+    removeLeaf(it->second);
+    freeNode(it->second);
+    leaves.erase(it);
+}
+
+void SectionTree::clear()
+{
+    treeNodes.clear();
+    root = none;
+    freeNodes = none;
+    leaves.clear();
+}
+
+void SectionTree::findInBox(const Box2f &box, std::vector<TrackSection *> *outSections) const
+{
+    outSections->clear();
+    if (root == none)
+        return;
+    std::vector<int> stack{root};
+    while (!stack.empty()) {
+        const TreeNode &node = treeNodes[stack.back()];
+        stack.pop_back();
+        if (!node.bounds.intersects(box))
+            continue;
+        if (node.isLeaf()) {
+            if (node.section->getBounds().intersects(box))
+                outSections->push_back(node.section);
+        } else {
+            stack.push_back(node.children[0]);
+            stack.push_back(node.children[1]);
+        }
+    }
+}
+
+void SectionTree::findWithinRadius(const Vec2f &point, float radius,
+                                   std::vector<TrackSection *> *outSections) const
+{
+    outSections->clear();
+    if (root == none)
+        return;
+    const float radiusSqr = radius * radius;
+    std::vector<int> stack{root};
+    while (!stack.empty()) {
+        const TreeNode &node = treeNodes[stack.back()];
+        stack.pop_back();
+        if (node.bounds.distanceSqr(point) > radiusSqr)
+            continue;
+        if (node.isLeaf()) {
+            int trackIndex;
+            float distance, separation;
+            if (node.section->findClosestPoint(point, &trackIndex, &distance, &separation) &&
+                    separation <= radius)
+                outSections->push_back(node.section);
+        } else {
+            stack.push_back(node.children[0]);
+            stack.push_back(node.children[1]);
+        }
+    }
+}
+
+// Find how far along a ray it enters a box, if it does before length
+static bool rayEntry(const Box2f &box, const Vec2f &origin, const Vec2f &direction,
+                     float length, float *outEntry)
+{
+    if (box.empty())
+        return false;
+    float entry = 0, exit = length;
+    for (int i = 0; i < 2; ++i) {
+        if (direction[i] == 0) {
+            // Parallel to these sides
+            if (origin[i] < box.getMin()[i] || origin[i] > box.getMax()[i])
+                return false;
+            continue;
+        }
+        float t1 = (box.getMin()[i] - origin[i]) / direction[i];
+        float t2 = (box.getMax()[i] - origin[i]) / direction[i];
+        entry = std::max(entry, std::min(t1, t2));
+        exit = std::min(exit, std::max(t1, t2));
+        if (entry > exit)
+            return false;
+    }
+    *outEntry = entry;
+    return true;
+}
+
+void SectionTree::findOnRay(const Vec2f &origin, const Vec2f &direction, float length,
+                            std::vector<TrackSection *> *outSections) const
+{
+    outSections->clear();
+    if (root == none)
+        return;
+    std::vector<std::pair<float, TrackSection *>> found;
+    std::vector<int> stack{root};
+    float entry;
+    while (!stack.empty()) {
+        const TreeNode &node = treeNodes[stack.back()];
+        stack.pop_back();
+        if (!rayEntry(node.bounds, origin, direction, length, &entry))
+            continue;
+        if (node.isLeaf()) {
+            if (rayEntry(node.section->getBounds(), origin, direction, length, &entry))
+                found.push_back({entry, node.section});
+        } else {
+            stack.push_back(node.children[0]);
+            stack.push_back(node.children[1]);
+        }
+    }
+    std::sort(found.begin(), found.end());
+    for (const auto &hit: found)
+        outSections->push_back(hit.second);
+}
+
+TrackSection *SectionTree::findClosestTrack(const Vec2f &point, float maxSeparation,
+                                            int *outTrackIndex, float *outDistance) const
+{
+    if (root == none)
+        return nullptr;
+
+    // Visit nodes nearest first, until none can be closer than the best
+    typedef std::pair<float, int> Candidate;
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> queue;
+    queue.push({treeNodes[root].bounds.distanceSqr(point), root});
+    TrackSection *best = nullptr;
+    float bestSeparation = maxSeparation;
+    while (!queue.empty() && queue.top().first < bestSeparation * bestSeparation) {
+        const TreeNode &node = treeNodes[queue.top().second];
+        queue.pop();
+        if (node.isLeaf()) {
+            int trackIndex;
+            float distance, separation;
+            if (node.section->findClosestPoint(point, &trackIndex, &distance, &separation) &&
+                    separation < bestSeparation) {
+                best = node.section;
+                bestSeparation = separation;
+                *outTrackIndex = trackIndex;
+                *outDistance = distance;
+            }
+        } else {
+            for (int child: node.children) {
+                float distanceSqr = treeNodes[child].bounds.distanceSqr(point);
+                if (distanceSqr < bestSeparation * bestSeparation)
+                    queue.push({distanceSqr, child});
+            }
+        }
+    }
+    return best;
+}
+
+int SectionTree::allocateNode()
+{
+    int index;
+    if (freeNodes != none) {
+        index = freeNodes;
+        freeNodes = treeNodes[index].parent;
+    } else {
+        index = treeNodes.size();
+        treeNodes.emplace_back();
+    }
+    TreeNode &node = treeNodes[index];
+    node.bounds = Box2f();
+    node.parent = none;
+    node.children[0] = node.children[1] = none;
+    node.section = nullptr;
+    node.height = 0;
+    return index;
+}
+
+void SectionTree::freeNode(int index)
+{
+    treeNodes[index].height = -1;
+    treeNodes[index].parent = freeNodes;
+    freeNodes = index;
+}
+
+Box2f SectionTree::sectionBounds(const TrackSection *section) const
+{
+    // Sections without a shape are kept at their start
+    Box2f bounds = section->getBounds();
+    if (bounds.empty()) {
+        Vec2f start = (Vec2f)section->start().getMidpoint();
+        bounds = Box2f(start, start);
+    }
+    return bounds;
+}
+
+void SectionTree::insertLeaf(int leaf)
+{
+    if (root == none) {
+        root = leaf;
+        treeNodes[leaf].parent = none;
+        return;
+    }
+
+    // Descend towards the sibling whose new parent adds least to the total
+    // size of the tree, counting the growth of the ancestors on the way
+    const Box2f leafBounds = treeNodes[leaf].bounds;
+    int index = root;
+    while (!treeNodes[index].isLeaf()) {
+        const TreeNode &node = treeNodes[index];
+        Box2f combined = node.bounds;
+        combined.include(leafBounds);
+        float combinedSize = combined.sideSum();
+        float cost = 2 * combinedSize;
+        float inheritance = 2 * (combinedSize - node.bounds.sideSum());
+
+        float childCosts[2];
+        for (int c = 0; c < 2; ++c) {
+            const TreeNode &child = treeNodes[node.children[c]];
+            Box2f childCombined = child.bounds;
+            childCombined.include(leafBounds);
+            childCosts[c] = childCombined.sideSum() + inheritance;
+            if (!child.isLeaf())
+                childCosts[c] -= child.bounds.sideSum();
+        }
+        if (cost < childCosts[0] && cost < childCosts[1])
+            break;
+        index = node.children[childCosts[0] <= childCosts[1] ? 0 : 1];
+    }
+
+    // Join the leaf and sibling under a new parent
+    int sibling = index;
+    int oldParent = treeNodes[sibling].parent;
+    int newParent = allocateNode();
+    TreeNode &parent = treeNodes[newParent];
+    parent.parent = oldParent;
+    parent.children[0] = sibling;
+    parent.children[1] = leaf;
+    parent.bounds = leafBounds;
+    parent.bounds.include(treeNodes[sibling].bounds);
+    parent.height = treeNodes[sibling].height + 1;
+    treeNodes[sibling].parent = newParent;
+    treeNodes[leaf].parent = newParent;
+    if (oldParent == none) {
+        root = newParent;
+    } else {
+        int *children = treeNodes[oldParent].children;
+        children[children[0] == sibling ? 0 : 1] = newParent;
+    }
+
+    refitAncestors(newParent);
+}
+
+void SectionTree::removeLeaf(int leaf)
+{
+    if (leaf == root) {
+        root = none;
+        return;
+    }
+
+    // Replace the parent with the sibling
+    int parent = treeNodes[leaf].parent;
+    int grandparent = treeNodes[parent].parent;
+    const int *siblings = treeNodes[parent].children;
+    int sibling = siblings[siblings[0] == leaf ? 1 : 0];
+    treeNodes[sibling].parent = grandparent;
+    freeNode(parent);
+    if (grandparent == none) {
+        root = sibling;
+    } else {
+        int *children = treeNodes[grandparent].children;
+        children[children[0] == parent ? 0 : 1] = sibling;
+        refitAncestors(grandparent);
+    }
+}
+
+void SectionTree::refitAncestors(int index)
+{
+    while (index != none) {
+        TreeNode &node = treeNodes[index];
+        const TreeNode &child0 = treeNodes[node.children[0]];
+        const TreeNode &child1 = treeNodes[node.children[1]];
+        node.bounds = child0.bounds;
+        node.bounds.include(child1.bounds);
+        node.height = 1 + std::max(child0.height, child1.height);
+        index = treeNodes[balance(index)].parent;
+    }
+}
+
+int SectionTree::balance(int index)
+{
+    TreeNode &node = treeNodes[index];
+    if (node.isLeaf() || node.height < 2)
+        return index;
+
+    // Promote the taller child if it is more than one level taller
+    int heightDifference = treeNodes[node.children[1]].height
+                         - treeNodes[node.children[0]].height;
+    int side;
+    if (heightDifference > 1)
+        side = 1;
+    else if (heightDifference < -1)
+        side = 0;
+    else
+        return index;
+
+    int promoted = node.children[side];
+    TreeNode &up = treeNodes[promoted];
+    int grandchild0 = up.children[0];
+    int grandchild1 = up.children[1];
+
+    // The promoted child takes the node's place, with the node under it
+    up.parent = node.parent;
+    node.parent = promoted;
+    if (up.parent == none) {
+        root = promoted;
+    } else {
+        int *children = treeNodes[up.parent].children;
+        children[children[0] == index ? 0 : 1] = promoted;
+    }
+
+    // The taller grandchild stays with the promoted child, and the other
+    // replaces it under the node
+    int keep = grandchild0, move = grandchild1;
+    if (treeNodes[grandchild1].height > treeNodes[grandchild0].height)
+        std::swap(keep, move);
+    up.children[0] = index;
+    up.children[1] = keep;
+    node.children[side] = move;
+    treeNodes[move].parent = index;
+
+    for (TreeNode *changed: {&node, &up}) {
+        const TreeNode &child0 = treeNodes[changed->children[0]];
+        const TreeNode &child1 = treeNodes[changed->children[1]];
+        changed->bounds = child0.bounds;
+        changed->bounds.include(child1.bounds);
+        changed->height = 1 + std::max(child0.height, child1.height);
+    }
+    return promoted;
+}
@@ -0,0 +1,94 @@
+#ifndef TRAINS_SECTION_TREE_H
+#define TRAINS_SECTION_TREE_H
+
+#include "BoundingBox.h"
+#include "Vector.h"
+
+#include <unordered_map>
+#include <vector>
+
+class TrackSection;
+
+/*
+ * Dynamic bounding volume hierarchy of track section bounds, for finding
+ * sections in an area without visiting every one. Leaves hold bounds grown
+ * by a margin, so sections that change a little don't need to move in the
+ * tree. Leaves are inserted next to the sibling least increasing the size
+ * of the tree, and rotations keep it balanced.
+ */
+class SectionTree
+{
+private:
+    static constexpr int none = -1;
+
+    struct TreeNode {
+        Box2f bounds;
+        int parent;
+        // Both none for leaves
+        int children[2];
+        // Leaf section, or nullptr
+        TrackSection *section;
+        // Leaves are at height 0, or -1 if the node is free
+        int height;
+
+        bool isLeaf() const
+        {
+            return children[0] == none;
+        }
+    };
+
+    // Nodes, with free ones chained through parent
+    std::vector<TreeNode> treeNodes;
+    int root;
+    int freeNodes;
+    // Leaf node of each section
+    std::unordered_map<const TrackSection *, int> leaves;
+    float margin;
+
+public:
+    explicit SectionTree(float newMargin = 4.0f);
+
+    void insert(TrackSection *section);
+    // Refit a section after its bounds change
+    void update(TrackSection *section);
+    void remove(TrackSection *section);
+    void clear();
+
+    size_t size() const
+    {
+        return leaves.size();
+    }
+    // Height of the tree, for checking balance
+    int getHeight() const
+    {
+        return root == none ? 0 : treeNodes[root].height + 1;
+    }
+
+    // Sections whose bounds intersect box
+    void findInBox(const Box2f &box, std::vector<TrackSection *> *outSections) const;
+    // Sections with a track within radius of point
+    void findWithinRadius(const Vec2f &point, float radius,
+                          std::vector<TrackSection *> *outSections) const;
+    // Sections whose bounds a ray from origin along unit direction passes
+    // through within length, nearest first
+    void findOnRay(const Vec2f &origin, const Vec2f &direction, float length,
+                   std::vector<TrackSection *> *outSections) const;
+    // Find the section with the track closest to point, within maxSeparation,
+    // and the track and distance along it. Returns nullptr if there is none.
+    TrackSection *findClosestTrack(const Vec2f &point, float maxSeparation,
+                                   int *outTrackIndex, float *outDistance) const;
+
+private:
+    int allocateNode();
+    void freeNode(int index);
+    Box2f sectionBounds(const TrackSection *section) const;
+
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    // Recalculate bounds and heights from index to the root, rebalancing
+    void refitAncestors(int index);
+    // Rotate an unbalanced subtree, returning its new root
+    int balance(int index);
+};
+
+#endif // TRAINS_SECTION_TREE_H
@@ -0,0 +1,182 @@
+#ifndef TRAINS_SLOT_MAP_H
+#define TRAINS_SLOT_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+template <typename T>
+class SlotMap;
+
+// Handle to an object in a SlotMap<T>. Handles of removed objects stop
+// resolving, even once their slot is reused. The default handle is null.
+template <typename T>
+class SlotId
+{
+private:
+    friend class SlotMap<T>;
+
+    uint32_t index;
+    // Generation of the slot when the object was inserted, never 0
+    uint32_t generation;
+
+    SlotId(uint32_t newIndex, uint32_t newGeneration)
+    : index(newIndex),
+      generation(newGeneration)
+    {
+    }
+
+public:
+    SlotId()
+    : index(0),
+      generation(0)
+    {
+    }
+
+    explicit operator bool () const
+    {
+        return generation != 0;
+    }
+    bool operator == (const SlotId &other) const
+    {
+        return index == other.index && generation == other.generation;
+    }
+    bool operator != (const SlotId &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+/*
+ * Generational slot map owning heap allocated objects. Objects are looked up
+ * and removed by handle in constant time, and the live objects are kept
+ * packed in one array for iteration. Objects themselves don't move, so raw
+ * pointers between them stay valid until they are removed; handles are for
+ * holders that may outlive them. Removing deletes the object, and must not
+ * be done while iterating.
+ */
+template <typename T>
+class SlotMap
+{
+public:
+    typedef SlotId<T> Id;
+    typedef typename std::vector<T *>::const_iterator const_iterator;
+
+private:
+    static constexpr uint32_t none = UINT32_MAX;
+
+    struct Slot {
+        uint32_t generation;
+        // Index in objects while live, or the next free slot
+        uint32_t next;
+    };
+    std::vector<Slot> slots;
+    uint32_t freeSlots;
+
+    // Live objects and their slots, packed
+    std::vector<T *> objects;
+    std::vector<uint32_t> objectSlots;
+
+public:
+    SlotMap()
+    : freeSlots(none)
+    {
+    }
+    SlotMap(const SlotMap &) = delete;
+    SlotMap &operator = (const SlotMap &) = delete;
+    ~SlotMap()
+    {
+        clear();
+    }
+
+    // Take ownership of an object
+    Id insert(T *object)
+    {
+        uint32_t index;
+        if (freeSlots != none) {
+            index = freeSlots;
+            freeSlots = slots[index].next;
+        } else {
+            index = slots.size();
+            slots.push_back({1, none});
+        }
+        slots[index].next = objects.size();
+        objects.push_back(object);
+        objectSlots.push_back(index);
+        return Id(index, slots[index].generation);
+    }
+
+    // Find an object, or nullptr if it has been removed
+    T *get(Id id) const
+    {
+        if (!contains(id))
+            return nullptr;
+        return objects[slots[id.index].next];
+    }
+    bool contains(Id id) const
+    {
+        return id.index < slots.size() && id.generation == slots[id.index].generation;
+    }
+
+    // Delete an object, returning false if it was already removed
+    bool remove(Id id)
+    {
+        if (!contains(id))
+            return false;
+        Slot &slot = slots[id.index];
+        uint32_t dense = slot.next;
+        delete objects[dense];
+
+        // Move the last object into the gap
+        objects[dense] = objects.back();
+        objectSlots[dense] = objectSlots.back();
+        slots[objectSlots[dense]].next = dense;
+        objects.pop_back();
+        objectSlots.pop_back();
+
+        // Invalidate handles to the slot, skipping the null generation
+        if (++slot.generation == 0)
+            slot.generation = 1;
+        slot.next = freeSlots;
+        freeSlots = id.index;
+        return true;
+    }
+
+    // Delete every object, invalidating all handles
+    void clear()
+    {
+        for (T *object: objects)
+            delete object;
+        objects.clear();
+        objectSlots.clear();
+        // Free every slot, with a new generation
+        freeSlots = none;
+        for (uint32_t index = slots.size(); index-- > 0;) {
+            Slot &slot = slots[index];
+            if (++slot.generation == 0)
+                slot.generation = 1;
+            slot.next = freeSlots;
+            freeSlots = index;
+        }
+    }
+
+    size_t size() const
+    {
+        return objects.size();
+    }
+    bool empty() const
+    {
+        return objects.empty();
+    }
+
+    const_iterator begin() const
+    {
+        return objects.begin();
+    }
+    const_iterator end() const
+    {
+        return objects.end();
+    }
+};
+
+#endif // TRAINS_SLOT_MAP_H
@@ -0,0 +1,142 @@
+#ifndef TRAINS_SMALL_VECTOR_H
+#define TRAINS_SMALL_VECTOR_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+/*
+ * Array of trivially copyable items with space for N of them inline, only
+ * allocating from the heap when it grows beyond that. For small per-object
+ * collections, such as a node's tracks and sections, where a separate
+ * allocation for each object would cost more memory and cache misses than
+ * the items themselves.
+ */
+template <typename T, unsigned int N>
+class SmallVector
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SmallVector items are moved with memcpy");
+
+private:
+    // Inline storage, or the heap once grown beyond it
+    T *items;
+    uint32_t count;
+    uint32_t capacity;
+    alignas(T) unsigned char inlineItems[N * sizeof(T)];
+
+    bool isInline() const
+    {
+        return items == reinterpret_cast<const T *>(inlineItems);
+    }
+
+    void reserve(uint32_t newCapacity)
+    {
+        if (newCapacity <= capacity)
+            return;
+        T *newItems = static_cast<T *>(::operator new(newCapacity * sizeof(T)));
+        memcpy(static_cast<void *>(newItems), items, count * sizeof(T));
+        if (!isInline())
+            ::operator delete(items);
+        items = newItems;
+        capacity = newCapacity;
+    }
+
+public:
+    enum { inlineCapacity = N };
+
+    SmallVector()
+    : items(reinterpret_cast<T *>(inlineItems)),
+      count(0),
+      capacity(N)
+    {
+    }
+    // Items may be in the inline storage, which copies would still point to
+    SmallVector(const SmallVector &) = delete;
+    SmallVector &operator = (const SmallVector &) = delete;
+    ~SmallVector()
+    {
+        if (!isInline())
+            ::operator delete(items);
+    }
+
+    unsigned int size() const
+    {
+        return count;
+    }
+    bool empty() const
+    {
+        return !count;
+    }
+    // Whether the items have spilled onto the heap
+    bool onHeap() const
+    {
+        return !isInline();
+    }
+    size_t heapBytes() const
+    {
+        return isInline() ? 0 : capacity * sizeof(T);
+    }
+
+    T &operator [] (unsigned int i)
+    {
+        assert(i < count);
+        return items[i];
+    }
+    const T &operator [] (unsigned int i) const
+    {
+        assert(i < count);
+        return items[i];
+    }
+
+    T *begin()
+    {
+        return items;
+    }
+    T *end()
+    {
+        return items + count;
+    }
+    const T *begin() const
+    {
+        return items;
+    }
+    const T *end() const
+    {
+        return items + count;
+    }
+
+    void push_back(const T &item)
+    {
+        if (count == capacity)
+            reserve(capacity * 2);
+        items[count++] = item;
+    }
+
+    // Resize, value initialising new items
+    void resize(unsigned int newCount)
+    {
+        if (newCount > capacity)
+            reserve(newCount);
+        for (uint32_t i = count; i < newCount; ++i)
+            new (&items[i]) T();
+        count = newCount;
+    }
+
+    // Remove an item, keeping the order of the rest
+    void erase(T *item)
+    {
+        assert(item >= begin() && item < end());
+        memmove(static_cast<void *>(item), item + 1, (end() - item - 1) * sizeof(T));
+        --count;
+    }
+
+    void clear()
+    {
+        count = 0;
+    }
+};
+
+#endif // TRAINS_SMALL_VECTOR_H
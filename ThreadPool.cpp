@@ -0,0 +1,86 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int numThreads)
+: job(nullptr),
+  jobCount(0),
+  nextIndex(0),
+  generation(0),
+  busyWorkers(0),
+  stopping(false)
+{
+    if (!numThreads)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    workers.reserve(numThreads - 1);
+    for (unsigned int i = 1; i < numThreads; ++i)
+        workers.emplace_back(&ThreadPool::workerMain, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    startCondition.notify_all();
+    for (std::thread &worker: workers)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &func)
+{
+    if (workers.empty() || count < 2) {
+        for (size_t i = 0; i < count; ++i)
+            func(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &func;
+        jobCount = count;
+        nextIndex = 0;
+        busyWorkers = workers.size();
+        ++generation;
+    }
+    startCondition.notify_all();
+
+    runJob();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this]() { return busyWorkers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::workerMain()
+{
+    unsigned int lastGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            startCondition.wait(lock, [&]() {
+                return stopping || generation != lastGeneration;
+            });
+            if (stopping)
+                return;
+            lastGeneration = generation;
+        }
+
+        runJob();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0)
+            doneCondition.notify_one();
+    }
+}
+
+void ThreadPool::runJob()
+{
+    for (;;) {
+        size_t i = nextIndex++;
+        if (i >= jobCount)
+            break;
+        (*job)(i);
+    }
+}
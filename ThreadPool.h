@@ -0,0 +1,50 @@
+#ifndef TRAINS_THREAD_POOL_H
+#define TRAINS_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads for running independent loop iterations
+class ThreadPool
+{
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+    // Current loop, shared with workers
+    const std::function<void(size_t)> *job;
+    size_t jobCount;
+    std::atomic<size_t> nextIndex;
+    // Incremented to start each loop
+    unsigned int generation;
+    // Workers yet to finish the current loop
+    unsigned int busyWorkers;
+    bool stopping;
+
+public:
+    // Number of threads including the caller, or 0 for one per hardware thread
+    explicit ThreadPool(unsigned int numThreads = 0);
+    ~ThreadPool();
+
+    unsigned int getNumThreads() const
+    {
+        return workers.size() + 1;
+    }
+
+    // Call func(i) for each i from 0 to count-1 in any order on any thread,
+    // including the caller, and return once all have finished
+    void parallelFor(size_t count, const std::function<void(size_t)> &func);
+
+private:
+    void workerMain();
+    void runJob();
+};
+
+#endif // TRAINS_THREAD_POOL_H
@@ -124,6 +124,8 @@ void TrackMode::mouseDown(const LineUnit3f &ray, int button, int clicks)
                 dragIndex = index;
                 changed = true;
             }
+            // Draft section shapes while dragging
+            railway->setInteractive(dragMode != NONE);
             if (changed)
                 updateHandles();
         } else if (clicks == 2) {
@@ -212,6 +214,7 @@ void TrackMode::mouseDown(const LineUnit3f &ray, int button, int clicks)
 
             selectedNode = endNode;
             dragMode = MOVE;
+            railway->setInteractive(true);
             updateHandles();
         }
     } else if (button == 1) {
@@ -220,6 +223,7 @@ void TrackMode::mouseDown(const LineUnit3f &ray, int button, int clicks)
             // Reset curvature
             selectedNode->setCurvature(0);
             dragMode = NONE;
+            railway->setInteractive(false);
             updateHandles();
         }
     }
@@ -229,8 +233,9 @@ void TrackMode::mouseUp(const LineUnit3f &ray, int button, int clicks)
 {
     // Left button
     if (button == 0) {
-        // Finish dragging
+        // Finish dragging, refining the sections' shapes
         dragMode = NONE;
+        railway->setInteractive(false);
         updateHandles();
     }
 }
@@ -254,7 +259,7 @@ void TrackMode::updateHandles()
         sincosf(direction + M_PI/2, &directionVector[1], &directionVector[0]);
         directionVector[2] = 0;
 
-        Clothoid<float, float> clothoid;
+        Clothoid<float, float, FresnelTable> clothoid;
         clothoid.setStartPosition((Vec2f)position);
         clothoid.setStartDirection(direction);
         clothoid.setStartCurvature(selectedNode->getCurvature());
@@ -283,6 +288,8 @@ void TrackMode::updateHandles()
                 handles[4 + i*2 + d].mode = POINTS;
                 handles[4 + i*2 + d].index = i*2 + d;
                 if (selectedNode->hasPoints(i, (bool)d)) {
+                    // Sections may be awaiting interpolation
+                    railway->interpolateDirty();
                     TrackPosition pos;
                     pos.set(selectedNode, true, i);
                     if (pos) {
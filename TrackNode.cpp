@@ -1,10 +1,11 @@
 #include "TrackNode.h"
+#include "Railway.h"
 #include "TrackSection.h"
 #include "TrackSpec.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
-#include <cstring>
 
 template class TrackNode::TReference<TrackNode *>;
 template class TrackNode::TReference<const TrackNode *>;
@@ -24,13 +25,11 @@ TrackSection *TrackNode::TReference<T>::nextSection(unsigned int trackIndex,
                                                     unsigned int *outTrackIndex,
                                                     bool *outForward) const
 {
-    if (!node->trackInfo)
-        return nullptr;
     int pTrackIndex = parentTrackIndex(trackIndex);
     assert(pTrackIndex >= 0 && "Negative track index");
     assert(pTrackIndex < node->getNumTracks() && "Track index out of bounds");
-    TrackDirectionInfo &tdInfo = node->trackInfo[pTrackIndex].directionInfo[forward ? 1 : 0];
-    SectionRef &ref = tdInfo.defaultSection();
+    const TrackDirectionInfo &tdInfo = node->trackInfo[pTrackIndex].directionInfo[forward ? 1 : 0];
+    SectionRef ref = tdInfo.defaultSection();
     if (!ref.section)
         return nullptr;
 
@@ -53,26 +52,25 @@ TrackNode::TrackNode(const TrackSpec *newMinSpec)
   curvature(0),
   numTracks(1),
   minSpec(newMinSpec),
-  trackInfo(nullptr)
+  railway(nullptr)
 {
+    trackInfo.resize(numTracks);
+    updateFrame();
 }
 
 TrackNode::~TrackNode()
 {
-    delete [] trackInfo;
 }
 
 bool TrackNode::addTrackSection(bool forward, int startTrack, int ofNumTracks,
                                 TrackSection *section, bool nextForward)
 {
-    allSections.insert(section);
+    if (std::find(allSections.begin(), allSections.end(), section) == allSections.end())
+        allSections.push_back(section);
 
     if (startTrack < 0 || startTrack + ofNumTracks > numTracks)
         return false;
 
-    if (!trackInfo)
-        trackInfo = new TrackInfo[numTracks];
-
     // Check all the tracks have space
     for (int i = startTrack; i < startTrack + ofNumTracks; ++i)
         if (!trackInfo[i].directionInfo[forward ? 1 : 0].hasSpaceForSection(section))
@@ -87,9 +85,19 @@ bool TrackNode::addTrackSection(bool forward, int startTrack, int ofNumTracks,
     return true;
 }
 
+void TrackNode::removeTrackSection(TrackSection *section)
+{
+    TrackSection **found = std::find(allSections.begin(), allSections.end(), section);
+    if (found != allSections.end())
+        allSections.erase(found);
+    for (unsigned int i = 0; i < numTracks; ++i)
+        for (TrackDirectionInfo &tdInfo: trackInfo[i].directionInfo)
+            tdInfo.removeSection(section);
+}
+
 bool TrackNode::hasPoints(unsigned int trackIndex, bool forward) const
 {
-    if (!trackInfo || trackIndex >= numTracks)
+    if (trackIndex >= numTracks)
         return false;
 
     return trackInfo[trackIndex].directionInfo[forward ? 1 : 0].numSections > 1;
@@ -97,7 +105,7 @@ bool TrackNode::hasPoints(unsigned int trackIndex, bool forward) const
 
 void TrackNode::switchPoints(unsigned int trackIndex, bool forward)
 {
-    if (!trackInfo || trackIndex >= numTracks)
+    if (trackIndex >= numTracks)
         return;
 
     trackInfo[trackIndex].directionInfo[forward ? 1 : 0].switchPoints();
@@ -105,17 +113,42 @@ void TrackNode::switchPoints(unsigned int trackIndex, bool forward)
 
 void TrackNode::notifySections()
 {
-    for (int i = 0; i < 2; ++i)
-        for (TrackSection *section: allSections)
-            section->notifyNodeChanged(this);
+    for (TrackSection *section: allSections)
+        section->notifyNodeChanged(this);
+}
+
+void TrackNode::notifyMoved()
+{
+    if (railway)
+        railway->notifyNodeMoved(this);
+    notifySections();
 }
 
 void TrackNode::setMidpoint(const Vec3f &midpoint)
 {
-    Vec2f leftVec;
-    sincosf(direction + M_PI/2, &leftVec[1], &leftVec[0]);
     float displacement = getMidpointOffset();
-    setPosition(midpoint + (leftVec * displacement, 0.0f));
+    setPosition(midpoint - (rightVec * displacement, 0.0f));
+}
+
+void TrackNode::updateFrame()
+{
+    sincosf(direction - M_PI/2, &rightVec[1], &rightVec[0]);
+    updateTracks();
+}
+
+void TrackNode::updateTracks()
+{
+    for (unsigned int i = 0; i < numTracks; ++i) {
+        TrackInfo &info = trackInfo[i];
+        if (i == 0) {
+            info.position = position;
+            info.curvature = curvature;
+        } else {
+            float displacement = getTrackOffset(i);
+            info.position = offsetPosition(displacement);
+            info.curvature = offsetCurvature(displacement);
+        }
+    }
 }
 
 void TrackNode::setNumTracks(unsigned int newNumTracks)
@@ -123,15 +156,12 @@ void TrackNode::setNumTracks(unsigned int newNumTracks)
     if (numTracks == newNumTracks)
         return;
 
-    if (!trackInfo || newNumTracks > numTracks) {
-        TrackInfo *newTrackInfo = new TrackInfo[newNumTracks];
-        if (trackInfo)
-            memcpy(newTrackInfo, trackInfo, sizeof(newTrackInfo[0])*numTracks);
-        delete [] trackInfo;
-        trackInfo = newTrackInfo;
-    }
-
+    trackInfo.resize(newNumTracks);
     numTracks = newNumTracks;
+    updateTracks();
+    // The midpoint depends on the number of tracks
+    if (railway)
+        railway->notifyNodeMoved(this);
 }
 
 float TrackNode::getMidpointOffset() const
@@ -153,30 +183,5 @@ Vec3f TrackNode::getMidpoint(int startTrack, int ofNumTracks) const
 {
     if (ofNumTracks < 0)
         ofNumTracks = numTracks;
-    Vec2f rightVec;
-    sincosf(direction - M_PI/2, &rightVec[1], &rightVec[0]);
-    float displacement = getMidpointOffset(startTrack, ofNumTracks);
-    return position + (rightVec * displacement, 0.0f);
-}
-
-Vec3f TrackNode::getPosition(int trackIndex) const
-{
-    if (trackIndex == 0) {
-        return position;
-    } else {
-        Vec2f rightVec;
-        sincosf(direction - M_PI/2, &rightVec[1], &rightVec[0]);
-        float displacement = getTrackOffset(trackIndex);
-        return position + (rightVec * displacement, 0.0f);
-    }
-}
-
-float TrackNode::getCurvature(int trackIndex) const
-{
-    if (trackIndex == 0) {
-        return curvature;
-    } else {
-        float displacement = minSpec->getTrackSpacing() * 2 * trackIndex;
-        return 1.0f / (1.0f / curvature + displacement);
-    }
+    return offsetPosition(getMidpointOffset(startTrack, ofNumTracks));
 }
@@ -1,14 +1,19 @@
 #ifndef TRAINS_TRACK_NODE_H
 #define TRAINS_TRACK_NODE_H
 
+#include "SlotMap.h"
+#include "SmallVector.h"
 #include "Vector.h"
 
 #include <cassert>
-#include <unordered_set>
 
+class Railway;
+class TrackNode;
 class TrackSection;
 class TrackSpec;
 
+typedef SlotId<TrackNode> NodeId;
+
 class TrackNode
 {
 private:
@@ -21,43 +26,48 @@ private:
     float direction;
     // Curvature (radians/length CCW) of track 0
     float curvature;
+    // Unit vector to the right of direction, towards the higher tracks
+    Vec2f rightVec;
     // Number of tracks (numbered 0..numTracks-1) to right of position
     unsigned int numTracks;
 
     // Minimum track specifications
     const TrackSpec *minSpec;
 
+    // Railway to notify when the node moves, so it can re-index it
+    Railway *railway;
+    // Handle of the node in the railway
+    NodeId id;
+
     // When referring to track sections, we refer to a specific end
     class SectionRef {
     public:
         TrackSection *section;
         bool forward;
 
-        SectionRef()
-        : section(nullptr),
-          forward(true)
+        SectionRef(TrackSection *newSection, bool newForward)
+        : section(newSection),
+          forward(newForward)
         {
         }
-
-        void set(TrackSection *newSection, bool newForward)
-        {
-            section = newSection;
-            forward = newForward;
-        }
     };
 
     // We'll have one of these for each track in each direction
     class TrackDirectionInfo {
     public:
-        // Up to 3 sections leading off this track
-        SectionRef sections[maxDivergence];
+        // Up to maxDivergence sections leading off this track
+        TrackSection *sections[maxDivergence];
+        // Bit i set if sections[i] is entered at its start
+        unsigned char forwardMask;
         // The number of sections
         unsigned char numSections;
         // The current setting of the points
         unsigned char defaultIndex;
 
         TrackDirectionInfo()
-        : numSections(0),
+        : sections{},
+          forwardMask(0),
+          numSections(0),
           defaultIndex(0)
         {
         }
@@ -69,8 +79,8 @@ private:
             if (numSections < maxDivergence)
                 return true;
             // Or already in array?
-            for (const SectionRef &ref: sections)
-                if (ref.section == section)
+            for (unsigned int i = 0; i < numSections; ++i)
+                if (sections[i] == section)
                     return true;
             // Otherwise it won't fit
             return false;
@@ -80,20 +90,43 @@ private:
         bool addSection(TrackSection *section, bool forward)
         {
             // Already in array?
-            for (const SectionRef &ref: sections)
-                if (ref.section == section)
+            for (unsigned int i = 0; i < numSections; ++i)
+                if (sections[i] == section)
                     return true;
             // Space in array?
             if (numSections < maxDivergence) {
-                sections[numSections++].set(section, forward);
+                if (forward)
+                    forwardMask |= 1 << numSections;
+                sections[numSections++] = section;
                 return true;
             }
             return false;
         }
 
-        SectionRef &defaultSection()
+        // Remove a section, keeping the points set the same way if possible
+        void removeSection(const TrackSection *section)
         {
-            return sections[defaultIndex];
+            unsigned int out = 0, newDefault = 0;
+            unsigned char newForwardMask = 0;
+            for (unsigned int i = 0; i < numSections; ++i) {
+                if (sections[i] == section)
+                    continue;
+                if (i == defaultIndex)
+                    newDefault = out;
+                if (forwardMask & (1 << i))
+                    newForwardMask |= 1 << out;
+                sections[out++] = sections[i];
+            }
+            for (unsigned int i = out; i < numSections; ++i)
+                sections[i] = nullptr;
+            forwardMask = newForwardMask;
+            numSections = out;
+            defaultIndex = newDefault;
+        }
+
+        SectionRef defaultSection() const
+        {
+            return SectionRef(sections[defaultIndex], forwardMask & (1 << defaultIndex));
         }
 
         void switchPoints()
@@ -110,13 +143,32 @@ private:
     public:
         // 0 = backwards, 1 = forwards
         TrackDirectionInfo directionInfo[2];
+        // Position and curvature of the track, kept up to date by updateTracks()
+        Vec3f position;
+        float curvature;
     };
 
-    // Track information
-    TrackInfo *trackInfo;
+    // Track information, one per track. Most nodes have one or two tracks,
+    // which are stored inline.
+    SmallVector<TrackInfo, 2> trackInfo;
+
+    // Every section attached to the node, usually only a few
+    SmallVector<TrackSection *, 4> allSections;
 
-    // Set of sections
-    std::unordered_set<TrackSection *> allSections;
+    // Recalculate rightVec and the tracks after the direction changes
+    void updateFrame();
+    // Recalculate the tracks' positions and curvatures. The track spacing of
+    // minSpec is assumed not to change once nodes use it.
+    void updateTracks();
+
+    Vec3f offsetPosition(float displacement) const
+    {
+        return position + (rightVec * displacement, 0.0f);
+    }
+    float offsetCurvature(float displacement) const
+    {
+        return 1.0f / (1.0f / curvature + displacement);
+    }
 
 public:
     // Encapsulates a reference to a node in a particular direction (forwards or
@@ -208,6 +260,11 @@ public:
             return *this = reversed();
         }
 
+        T getNode() const
+        {
+            return node;
+        }
+
         bool isForward() const
         {
             return forward;
@@ -344,31 +401,53 @@ public:
     // return false if track couldn't be added
     bool addTrackSection(bool forward, int startTrack, int ofNumTracks,
                          TrackSection *section, bool nextForward);
+    // Detach a section from every track, such as when deleting it
+    void removeTrackSection(TrackSection *section);
+
+    const SmallVector<TrackSection *, 4> &getSections() const
+    {
+        return allSections;
+    }
 
     bool hasPoints(unsigned int trackIndex, bool forward) const;
     void switchPoints(unsigned int trackIndex, bool forward);
 
     // Setters
 
+    void setRailway(Railway *newRailway, NodeId newId)
+    {
+        railway = newRailway;
+        id = newId;
+    }
+    NodeId getId() const
+    {
+        return id;
+    }
+
     void notifySections();
+    // Tell the railway and sections that the node has moved
+    void notifyMoved();
 
     void setMidpoint(const Vec3f &midpoint);
 
     void setPosition(const Vec3f &newPosition)
     {
         position = newPosition;
-        notifySections();
+        updateTracks();
+        notifyMoved();
     }
 
     void setDirection(float newDirection)
     {
         direction = newDirection;
-        notifySections();
+        updateFrame();
+        notifyMoved();
     }
 
     void setCurvature(float newCurvature)
     {
         curvature = newCurvature;
+        updateTracks();
         notifySections();
     }
 
@@ -385,14 +464,24 @@ public:
 
     Vec3f getMidpoint(int startTrack = 0, int ofNumTracks = -1) const;
 
-    Vec3f getPosition(int trackIndex = 0) const;
+    Vec3f getPosition(int trackIndex = 0) const
+    {
+        if ((unsigned int)trackIndex < numTracks)
+            return trackInfo[trackIndex].position;
+        return offsetPosition(getTrackOffset(trackIndex));
+    }
 
     float getDirection() const
     {
         return direction;
     }
 
-    float getCurvature(int trackIndex = 0) const;
+    float getCurvature(int trackIndex = 0) const
+    {
+        if ((unsigned int)trackIndex < numTracks)
+            return trackInfo[trackIndex].curvature;
+        return offsetCurvature(getTrackOffset(trackIndex));
+    }
 
     unsigned int getNumTracks() const
     {
@@ -51,7 +51,7 @@ Vec3f TrackPosition::getPosition(Mat22f *outRotMatrix) const
 {
     assert(section && "Section must be set to get position");
 
-    return section->getPosition(getSectionTrackIndex(), distance, outRotMatrix);
+    return section->getPosition(&cursor, getSectionTrackIndex(), distance, outRotMatrix);
 }
 
 void TrackPosition::turnAround()
@@ -1,10 +1,10 @@
 #ifndef TRAINS_TRACK_POSITION_H
 #define TRAINS_TRACK_POSITION_H
 
+#include "TrackSection.h"
 #include "Vector.h"
 
 class TrackNode;
-class TrackSection;
 
 class TrackPosition
 {
@@ -17,6 +17,9 @@ private:
     unsigned int trackIndex;
     // Distance along the track section (in section coordinates)
     float distance;
+    // Location in the section's clothoid chain of the last position query,
+    // which moves with us so that nearby queries need not search
+    mutable TrackSection::Cursor cursor;
 
 public:
     TrackPosition();
@@ -26,6 +29,10 @@ public:
     void set(const TrackSection *newSection, bool newForward = true,
              unsigned int newTrackIndex = 0, float newDistance = 0);
 
+    const TrackSection *getSection() const
+    {
+        return section;
+    }
     int getSectionTrackIndex() const;
 
     Vec3f getPosition(Mat22f *outRotMatrix = nullptr) const;
@@ -1,10 +1,22 @@
 #include "TrackSection.h"
+#include "InterpolationCache.h"
+#include "Railway.h"
+#include "TrackSectionStrategy.h"
 #include "TrackSpec.h"
 
+#include <chrono>
+#include <complex>
+#include <limits>
+#include <mutex>
+
 TrackSection::TrackSection(TrackNode::Reference start,
                            TrackNode::Reference end,
                            const TrackSpec *newMinSpec)
-: minSpec(newMinSpec),
+: railway(nullptr),
+  interpolationPending(false),
+  rough(false),
+  roughListed(false),
+  minSpec(newMinSpec),
   nodes{start, end},
   lastDir1(-1),
   lastDir2(-1)
@@ -29,6 +41,39 @@ Vec3f TrackSection::getPosition(int trackIndex, float distance,
     return (Vec3f)chain.parallelPositionAtParallelLength(-offset, distance, outRotMatrix);
 }
 
+Vec3f TrackSection::getPosition(Cursor *cursor, int trackIndex, float distance,
+                                Mat22f *outRotMatrix) const
+{
+    float offset = nodes[0].getTrackOffset(trackIndex) - nodes[0].getMidpointOffset();
+    return (Vec3f)chain.parallelPositionAtParallelLength(cursor, -offset, distance,
+                                                         outRotMatrix);
+}
+
+bool TrackSection::findClosestPoint(const Vec2f &point, int *outTrackIndex,
+                                    float *outDistance, float *outSeparation) const
+{
+    ClothoidChainT::Projection projection;
+    if (!chain.project(point, &projection))
+        return false;
+
+    // Parallel tracks share normals, so each is closest along the same one
+    const ClothoidT &clothoid = chain.clothoids()[projection.index];
+    float bestSeparation = std::numeric_limits<float>::max();
+    for (int track = 0; track < nodes[0].getNumTracks(); ++track) {
+        float offset = nodes[0].getTrackOffset(track) - nodes[0].getMidpointOffset();
+        Vec2f position = clothoid.parallelPositionAtLength(-offset, projection.length);
+        float separation = (position - point).mag();
+        if (separation < bestSeparation) {
+            bestSeparation = separation;
+            *outTrackIndex = track;
+            *outDistance = chain.parallelLengthAtLength(-offset, projection.index,
+                                                        projection.length);
+        }
+    }
+    *outSeparation = bestSeparation;
+    return true;
+}
+
 /**
  * @brief Calculate more complete clothoid parameters for a double opposite
  *        clothoid.
@@ -80,6 +125,153 @@ bool TrackSection::calcImpliedFromCurvatureRateAC(float directionDelta,
     return true;
 }
 
+// Convergence of interpolateClothoidPair(), which may run on many threads.
+// Each thread counts its own calls, adding them to the totals once per
+// section so parallel solves don't queue for the lock.
+static std::mutex clothoidPairStatsMutex;
+static TrackSection::ClothoidPairStats clothoidPairStats = {};
+static thread_local TrackSection::ClothoidPairStats pendingClothoidPairStats = {};
+
+static void flushClothoidPairStats()
+{
+    typedef TrackSection::ClothoidPairStats Stats;
+    Stats &pending = pendingClothoidPairStats;
+    if (!pending.calls)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(clothoidPairStatsMutex);
+        clothoidPairStats.calls += pending.calls;
+        clothoidPairStats.iterations += pending.iterations;
+        for (unsigned int i = 0; i < Stats::NumOutcomes; ++i)
+            clothoidPairStats.outcomes[i] += pending.outcomes[i];
+        for (unsigned int i = 0; i <= Stats::maxIterations; ++i)
+            clothoidPairStats.iterationCounts[i] += pending.iterationCounts[i];
+    }
+    pending = {};
+}
+
+TrackSection::ClothoidPairStats TrackSection::getClothoidPairStats()
+{
+    // Include any calls made outside interpolate() on this thread
+    flushClothoidPairStats();
+    std::lock_guard<std::mutex> lock(clothoidPairStatsMutex);
+    return clothoidPairStats;
+}
+
+void TrackSection::resetClothoidPairStats()
+{
+    pendingClothoidPairStats = {};
+    std::lock_guard<std::mutex> lock(clothoidPairStatsMutex);
+    clothoidPairStats = {};
+}
+
+static void recordClothoidPair(unsigned int iterations,
+                               TrackSection::ClothoidPairStats::Outcome outcome)
+{
+    TrackSection::ClothoidPairStats &pending = pendingClothoidPairStats;
+    ++pending.calls;
+    pending.iterations += iterations;
+    ++pending.outcomes[outcome];
+    if (outcome == TrackSection::ClothoidPairStats::Converged)
+        ++pending.iterationCounts[iterations];
+}
+
+/**
+ * @brief Find the end of a double opposite clothoid, and how it moves with
+ *        the initial curvature rate.
+ * @param directionA[in]          Direction at start (radians CCW from east).
+ * @param curvatureA[in]          Initial curvature (radians/length CCW).
+ * @param directionDelta[in]      Final direction (radians CCW from initial
+ *                                direction, in range -M_PI..M_PI).
+ * @param curvatureB[in]          Final curvature (radians/length CCW).
+ * @param curvatureRateAC[in]     Chosen curvature rate to maximum curvature.
+ * @param outCurvatureRateCB[out] Curvature rate from maximum curvature to end.
+ * @param outLengthAC[out]        Length of curve to maximum curvature.
+ * @param outLengthCB[out]        Length of curve from maximum curvature to end.
+ * @param outPosition[out]        End position relative to start.
+ * @param outDerivative[out]      Derivative of end position with respect to
+ *                                @curvatureRateAC, zero if unknown, or nullptr.
+ * @returns Whether a pair exists with @curvatureRateAC.
+ */
+bool TrackSection::evaluateClothoidPair(float directionA, float curvatureA,
+                                        float directionDelta, float curvatureB,
+                                        float curvatureRateAC,
+                                        float *outCurvatureRateCB,
+                                        float *outLengthAC, float *outLengthCB,
+                                        Vec2f *outPosition, Vec2f *outDerivative)
+{
+    if (!calcImpliedFromCurvatureRateAC(directionDelta, curvatureA, curvatureB,
+                                        curvatureRateAC, outCurvatureRateCB,
+                                        outLengthAC, outLengthCB))
+        return false;
+
+    ClothoidT c1;
+    c1.setStartDirection(directionA);
+    c1.setStartCurvature(curvatureA);
+    c1.setCurvatureRate(curvatureRateAC);
+    c1.setLength(*outLengthAC);
+    ClothoidT c2 = c1.getNextClothoid();
+    c2.setCurvatureRate(*outCurvatureRateCB);
+    c2.setLength(*outLengthCB);
+    *outPosition = c2.getEndPosition();
+    if (!outDerivative)
+        return true;
+
+    // The lengths change with the rate to keep the direction change, from
+    // the quadratic in calcImpliedFromCurvatureRateAC()
+    const double rate = curvatureRateAC;
+    const double lengthAC = *outLengthAC;
+    const double curvatureC = c2.getStartCurvature();
+    if (!curvatureC) {
+        *outDerivative = Vec2f(0.0f, 0.0f);
+        return true;
+    }
+    const double dLengthAC = (directionDelta / (2 * curvatureC) - lengthAC) / rate;
+    const double dLengthCB = dLengthAC - (curvatureA - curvatureB) / (rate * rate);
+    // Direction and curvature at the join
+    const double dDirectionC = curvatureC * dLengthAC + lengthAC * lengthAC / 2;
+    const double dCurvatureC = lengthAC + rate * dLengthAC;
+
+    // Moments ∫s^n e^iθ ds of each clothoid follow from its chord and end
+    // directions, as d/ds e^iθ = i(κ + κ's) e^iθ
+    typedef std::complex<double> Complex;
+    const Complex i(0, 1);
+    auto unit = [](float direction) {
+        float sin, cos;
+        sincosf(direction, &sin, &cos);
+        return Complex(cos, sin);
+    };
+    auto moments = [&i](const ClothoidT &c, const Complex &start, const Complex &end,
+                        const Complex &chord, Complex *outI1, Complex *outI2) {
+        double curvature = c.getStartCurvature();
+        double curvatureRate = c.getCurvatureRate();
+        *outI1 = (-i * (end - start) - curvature * chord) / curvatureRate;
+        *outI2 = -i * ((double)c.getLength() * end - chord - i * curvature * *outI1)
+               / curvatureRate;
+    };
+    const Complex unitA = unit(directionA);
+    const Complex unitC = unit(c2.getStartDirection());
+    const Complex unitB = unit(directionA + directionDelta);
+    // c1 starts at the origin
+    const Vec2f positionC = c2.getStartPosition();
+    const Complex chord1(positionC[0], positionC[1]);
+    const Complex chord2((*outPosition)[0] - positionC[0], (*outPosition)[1] - positionC[1]);
+    Complex moment1[3], moment2[3];
+    moment1[0] = chord1;
+    moment2[0] = chord2;
+    moments(c1, unitA, unitC, chord1, &moment1[1], &moment1[2]);
+    moments(c2, unitC, unitB, chord2, &moment2[1], &moment2[2]);
+
+    // Each point turns about the start by the change in direction before it
+    Complex derivative = dLengthAC * unitC
+                       + i * moment1[2] / 2.0
+                       + dLengthCB * unitB
+                       + i * (dDirectionC * moment2[0] + dCurvatureC * moment2[1]
+                              - moment2[2] / 2.0);
+    *outDerivative = Vec2f(derivative.real(), derivative.imag());
+    return true;
+}
+
 /**
  * @brief Calculate curvature rates to eliminate loops with a fixed curvature
  *        straight/curve after, using with a pair of clothoids.
@@ -106,8 +298,9 @@ bool TrackSection::interpolateClothoidPair(float directionA, float curvatureA,
                                            float *outRate2, float *outLen2,
                                            Vec2f *outPositionB, float *outExtraStraight)
 {
+    typedef ClothoidPairStats Stats;
     // TODO handle curvatureB != 0
-    constexpr unsigned int maxIterations = 32;
+    constexpr unsigned int maxIterations = Stats::maxIterations;
     // We know the start angle and curvature.
     // We know the final straight line we need to line up with.
     // We need to find a solution with 2 clothoids of equal and opposite
@@ -119,393 +312,460 @@ bool TrackSection::interpolateClothoidPair(float directionA, float curvatureA,
     while (directionDelta > M_PI)
         directionDelta -= M_PI*2;
 
-    // FIXME, need a better guess? than using curvatureRate?
-    const float curvatureRate = 1.0f / 30.0f / 10.0f;
-    float guess = directionDelta / positionB.sqr() * 4;
-    if (guess < -curvatureRate)
-        guess = -curvatureRate/100;
-    else if (guess > curvatureRate)
-        guess = curvatureRate/100;
-
-    ClothoidT c1, c2;
     Vec2f tangentVec;
     sincosf(directionB, &tangentVec[1], &tangentVec[0]);
     Vec2f perpendicularVec(-tangentVec[1], tangentVec[0]);
+    const float targetDist = positionB * perpendicularVec;
+
+    float curvatureRateCB, lengthAC, lengthCB;
+    Vec2f finalPos, finalPosDerivative;
+
+    // Starting straight, guess from the pair of equal clothoids to straight,
+    // whose shape just scales with the distance to the line. With unit
+    // lengths the curvature rate is the direction change.
+    float curvatureRateAC = 0;
+    if (!curvatureA && !curvatureB &&
+        evaluateClothoidPair(directionA, 0, directionDelta, 0, directionDelta,
+                             &curvatureRateCB, &lengthAC, &lengthCB,
+                             &finalPos, nullptr)) {
+        float scale = targetDist / (finalPos * perpendicularVec);
+        if (scale > 0 && std::isfinite(scale))
+            curvatureRateAC = directionDelta / (scale * scale);
+    }
+    // Otherwise try the rates giving a total length of the distance to
+    // positionB, from the turn and peak curvature (curvatureA + rate*length)/2:
+    // length² rate² + (2 curvatureA length - 4 directionDelta) rate - curvatureA² = 0
+    if (!curvatureRateAC) {
+        const float length = positionB.mag();
+        const float a = length * length;
+        const float halfB = curvatureA * length - 2 * directionDelta;
+        const float c = -curvatureA * curvatureA;
+        const float quarterB2m4ac = halfB*halfB - a*c;
+        float bestGuessDist = -1;
+        for (float sign: {-1.0f, 1.0f}) {
+            if (!a || quarterB2m4ac < 0)
+                break;
+            float rate = (-halfB + sign * sqrtf(quarterB2m4ac)) / a;
+            if (rate && evaluateClothoidPair(directionA, curvatureA, directionDelta,
+                                             curvatureB, rate, &curvatureRateCB,
+                                             &lengthAC, &lengthCB, &finalPos, nullptr)) {
+                float dist = fabs((finalPos - positionB) * perpendicularVec);
+                if (bestGuessDist < 0 || dist < bestGuessDist) {
+                    bestGuessDist = dist;
+                    curvatureRateAC = rate;
+                }
+            }
+        }
+    }
+    if (!curvatureRateAC) {
+        recordClothoidPair(0, Stats::FailureNoPair);
+        return false;
+    }
 
-    float curvatureRateAC = guess;
-    float curvatureRateCB[2];
-    float lengthAC[2], lengthCB[2];
-    Vec2f finalPos[2];
-    float dist[2];
+    // Newton-Raphson, falling back to bisection once the line is bracketed
+    // by rates falling short and overshooting
     const float minDist = 0.00001f;
-    for (int it = 0; it < maxIterations; ++it) {
-        const float delta = curvatureRateAC/100;
-        c1.setStartDirection(directionA);
-        c1.setStartCurvature(curvatureA);
-
-        for (int i = 0; i < 2; ++i) {
-            if (!calcImpliedFromCurvatureRateAC(directionDelta, curvatureA,
-                                                curvatureB, curvatureRateAC + delta*i,
-                                                &curvatureRateCB[i],
-                                                &lengthAC[i], &lengthCB[i])) {
+    // Accepted when the rate can't be refined further in float
+    const float maxRoundedDist = 0.001f;
+    // Give up without a bracket if the distance stops improving much
+    constexpr unsigned int maxWorseIterations = 3;
+    constexpr float minImprovement = 0.9f;
+    bool haveValid = false, haveShort = false, haveOver = false;
+    float validRate = 0, shortRate = 0, overRate = 0;
+    float bestDist = -1;
+    unsigned int worseIterations = 0;
+    for (unsigned int it = 0; it < maxIterations; ++it) {
+        if (!evaluateClothoidPair(directionA, curvatureA, directionDelta, curvatureB,
+                                  curvatureRateAC, &curvatureRateCB, &lengthAC, &lengthCB,
+                                  &finalPos, &finalPosDerivative)) {
+            // No pair at this rate, so back off towards one that worked
+            if (!haveValid || (!(haveShort && haveOver) &&
+                               ++worseIterations >= maxWorseIterations)) {
+                recordClothoidPair(it + 1, Stats::FailureNoPair);
+                return false;
+            }
+            curvatureRateAC = (curvatureRateAC + validRate) / 2;
+            continue;
+        }
+        haveValid = true;
+        validRate = curvatureRateAC;
+
+        float dist = (finalPos - positionB) * perpendicularVec;
+        float distDerivative = finalPosDerivative * perpendicularVec;
+        float nextRate = curvatureRateAC;
+        if (fabs(dist) >= minDist) {
+            if (dist < 0) {
+                haveShort = true;
+                shortRate = curvatureRateAC;
+            } else {
+                haveOver = true;
+                overRate = curvatureRateAC;
+            }
+            if (distDerivative) {
+                nextRate = curvatureRateAC - dist / distDerivative;
+                // Don't leap towards the enormous loops of tiny rates, or
+                // flip the direction of the first curve
+                nextRate = std::min(std::max(nextRate / curvatureRateAC, 0.25f), 4.0f)
+                         * curvatureRateAC;
+            }
+            bool bracketed = haveShort && haveOver;
+            if (bestDist < 0 || fabs(dist) < bestDist * minImprovement) {
+                bestDist = fabs(dist);
+                worseIterations = 0;
+            } else if (!bracketed && ++worseIterations >= maxWorseIterations) {
+                recordClothoidPair(it + 1, Stats::FailureStalled);
+                return false;
+            }
+            if (bracketed && (!distDerivative ||
+                              !(nextRate > std::min(shortRate, overRate) &&
+                                nextRate < std::max(shortRate, overRate))))
+                nextRate = (shortRate + overRate) / 2;
+            if (nextRate == curvatureRateAC && fabs(dist) >= maxRoundedDist) {
+                recordClothoidPair(it + 1, Stats::FailureStalled);
                 return false;
             }
-
-            c1.setCurvatureRate(curvatureRateAC + delta*i);
-            c1.setLength(lengthAC[i]);
-            c2 = c1.getNextClothoid();
-            c2.setCurvatureRate(curvatureRateCB[i]);
-            c2.setLength(lengthCB[i]);
-
-            finalPos[i] = c2.getEndPosition();
-            dist[i] = (finalPos[i] - positionB) * perpendicularVec;
         }
 
-        // Iterate, using the Neuton-Raphson method
-        curvatureRateAC -= delta * dist[0] / (dist[1] - dist[0]);
-
-        if (fabs(dist[0]) < minDist) {
+        if (nextRate == curvatureRateAC) {
             // Successfully converged
+            recordClothoidPair(it + 1, Stats::Converged);
             *outRate1 = curvatureRateAC;
-            *outLen1 = lengthAC[0];
-            *outRate2 = curvatureRateCB[0];
-            *outLen2 = lengthCB[0];
-            *outPositionB = finalPos[0];
-            *outExtraStraight = (positionB - finalPos[0]) * tangentVec;
+            *outLen1 = lengthAC;
+            *outRate2 = curvatureRateCB;
+            *outLen2 = lengthCB;
+            *outPositionB = finalPos;
+            *outExtraStraight = (positionB - finalPos) * tangentVec;
             return true;
         }
+        curvatureRateAC = nextRate;
     }
     // No convergence, fail!
+    recordClothoidPair(maxIterations, Stats::FailureIterations);
     return false;
 
 }
 
-struct SegmentParams {
-    float length;
-};
-struct TransitionParams : public SegmentParams {
-    float rate;
-};
-
-struct TrackSectionParams {
-    // Transition curves
-    TransitionParams t1, t2, t3, t4;
-    // Fixed curves
-    SegmentParams c1, c2;
-    // Straights
-    SegmentParams s;
-};
+/**
+ * @brief Calculate curvature rates to join a fixed curve, using a pair of
+ *        clothoids ending at its curvature.
+ * @param directionA            Direction at start (radians CCW from east).
+ * @param curvatureA            Curvature at start (radians/length CCW).
+ * @param positionB             Position of a known point on curve.
+ * @param directionB            Direction of curve at @p positionB, away from
+ *                              start (radians CCW from east).
+ * @param curvatureB            Curvature of curve, non-zero (radians/length
+ *                              CCW).
+ * @param outRate1[out]         Curvature rate from start to max curvature
+ *                              (radians/length² CCW).
+ * @param outLen1[out]          Length of clothoid from start to max curvature.
+ * @param outRate2[out]         Curvature rate from max curvature to curve.
+ * @param outLen2[out]          Length of clothoid from max curvature to curve.
+ * @param outExtraCurve[out]    Length of extra curve to reach @p positionB.
+ * @returns Whether a solution was found.
+ */
+bool TrackSection::interpolateClothoidPairToCurve(float directionA, float curvatureA,
+                                                  const Vec2f &positionB, float directionB,
+                                                  float curvatureB,
+                                                  float *outRate1, float *outLen1,
+                                                  float *outRate2, float *outLen2,
+                                                  float *outExtraCurve)
+{
+    if (!curvatureB)
+        return false;
+
+    // The pair must end on the circle facing along it, so with its centre
+    // of curvature at the circle's centre. Unlike onto a straight the turn
+    // isn't known, so Newton-Raphson finds both the rate and the turn.
+    auto centreOffset = [curvatureB](float direction) {
+        Vec2f normal;
+        sincosf(direction, &normal[0], &normal[1]);
+        normal[0] = -normal[0];
+        return normal / curvatureB;
+    };
+    const Vec2f centreB = positionB + centreOffset(directionB);
+
+    // Start from the pair onto the tangent at positionB
+    float curvatureRateAC, curvatureRateCB, lengthAC, lengthCB, extraStraight;
+    Vec2f finalPos, finalPosDerivative;
+    if (!interpolateClothoidPair(directionA, curvatureA, positionB, directionB,
+                                 curvatureB, &curvatureRateAC, &lengthAC,
+                                 &curvatureRateCB, &lengthCB, &finalPos, &extraStraight))
+        return false;
+    float directionDelta = directionB - directionA;
+    while (directionDelta < -M_PI)
+        directionDelta += M_PI*2;
+    while (directionDelta > M_PI)
+        directionDelta -= M_PI*2;
+
+    constexpr unsigned int maxIterations = ClothoidPairStats::maxIterations;
+    const float maxDist = 0.001f;
+    // Turn for the finite difference, large enough to survive float rounding
+    const float deltaStep = 0.001f;
+    const float maxDeltaChange = 0.5f;
+    constexpr unsigned int maxWorseIterations = 3;
+    float validRate = curvatureRateAC, validDelta = directionDelta;
+    float bestDist = -1;
+    unsigned int worseIterations = 0;
+    for (unsigned int it = 0; it < maxIterations; ++it) {
+        Vec2f stepPos;
+        float stepRateCB, stepLengthAC, stepLengthCB;
+        if (!evaluateClothoidPair(directionA, curvatureA, directionDelta, curvatureB,
+                                  curvatureRateAC, &curvatureRateCB, &lengthAC, &lengthCB,
+                                  &finalPos, &finalPosDerivative) ||
+            !evaluateClothoidPair(directionA, curvatureA, directionDelta + deltaStep,
+                                  curvatureB, curvatureRateAC, &stepRateCB,
+                                  &stepLengthAC, &stepLengthCB, &stepPos, nullptr)) {
+            // No pair here, so back off towards one that worked
+            if (++worseIterations >= maxWorseIterations)
+                return false;
+            curvatureRateAC = (curvatureRateAC + validRate) / 2;
+            directionDelta = (directionDelta + validDelta) / 2;
+            continue;
+        }
+        validRate = curvatureRateAC;
+        validDelta = directionDelta;
+
+        const Vec2f centreOffsetA = centreOffset(directionA + directionDelta);
+        const Vec2f error = finalPos + centreOffsetA - centreB;
+        const float dist = error.mag();
+        if (dist < maxDist) {
+            // Follow the circle round to positionB
+            float extraDelta = directionB - (directionA + directionDelta);
+            while (extraDelta < -M_PI)
+                extraDelta += M_PI*2;
+            while (extraDelta > M_PI)
+                extraDelta -= M_PI*2;
+            *outRate1 = curvatureRateAC;
+            *outLen1 = lengthAC;
+            *outRate2 = curvatureRateCB;
+            *outLen2 = lengthCB;
+            *outExtraCurve = extraDelta / curvatureB;
+            return true;
+        }
+        if (bestDist < 0 || dist < bestDist) {
+            bestDist = dist;
+            worseIterations = 0;
+        } else if (++worseIterations >= maxWorseIterations) {
+            return false;
+        }
+
+        // Solve the 2x2 Jacobian for the step in rate and turn
+        const Vec2f errorDelta = (stepPos + centreOffset(directionA + directionDelta + deltaStep)
+                                  - centreB - error) / deltaStep;
+        const float det = finalPosDerivative[0] * errorDelta[1]
+                        - finalPosDerivative[1] * errorDelta[0];
+        if (!det || !std::isfinite(det))
+            return false;
+        const float rateChange = (error[1] * errorDelta[0] - error[0] * errorDelta[1]) / det;
+        const float deltaChange = (error[0] * finalPosDerivative[1]
+                                   - error[1] * finalPosDerivative[0]) / det;
+        // Keep the direction of the first curve, as onto a straight
+        float nextRate = curvatureRateAC + rateChange;
+        nextRate = std::min(std::max(nextRate / curvatureRateAC, 0.25f), 4.0f)
+                 * curvatureRateAC;
+        curvatureRateAC = nextRate;
+        directionDelta += std::min(std::max(deltaChange, -maxDeltaChange), maxDeltaChange);
+    }
+    return false;
+}
 
 void TrackSection::interpolate()
 {
-    constexpr bool unloop1 = true;
-    constexpr bool unloop2 = true;
-    constexpr int d1start = 0;
-    constexpr int d1end = 2;
-    constexpr int d2start = 0;
-    constexpr int d2end = 2;
-
-    // TODO pick an appropriate rate
-    const float curvatureRate = minSpec->getMinCurvatureRate();
-    float minCurvature = minSpec->getMinCurvature();
-    const float maxCurvature = minSpec->getMaxCurvature();
-    const float startDirection = nodes[0].getDirection();
-    const float startCurvature = nodes[0].getCurvature();
-    const float endDirectionRev = nodes[1].getDirection();
-    const float endCurvatureRev = nodes[1].getCurvature();
-
-    int bestDir1, bestDir2;
-    float direction1 = -1.0f;
-    float direction2 = 1.0f;
-
-    // If multiple tracks to right, reduce curvature accordingly
-    if (nodes[0].getNumTracks() > 1) {
-        float displacement = minSpec->getTrackSpacing() * (nodes[0].getNumTracks() - 1) / 2;
-        minCurvature = 1.0f / (1.0f / minCurvature + displacement);
+    // Reuse the solution for the same relative node geometry if possible
+    InterpolationCache *cache = railway ? &railway->getInterpolationCache() : nullptr;
+    InterpolationCache::Key key;
+    InterpolationCache::Result result;
+    if (cache) {
+        key = InterpolationCache::makeKey(nodes[0], nodes[1], minSpec,
+                                          lastDir1, lastDir2);
     }
-
-    TrackSectionParams bestParams;
-
-    // individual clothoids excluding the curves and straights
-    ClothoidT uncurvedT1[2]; // from start to first curve
-    ClothoidT uncurvedT2[2]; // from first curve to straight
-    ClothoidT uncurvedT3[2][2]; // from straight to second curve
-    ClothoidT uncurvedT4rev[2]; // from end to second curve
-    ClothoidT uncurvedT3rev[2]; // from second curve to straight
-    ClothoidT uncurvedT2rev[2][2]; // from straight to first curve
-
-    // Indexed by d1
-    TransitionParams simpleT1[2], simpleT2[2];
-    // Indexed by d2
-    TransitionParams simpleT3[2], simpleT4[2];
-    float transition1DirectionChange[2];
-    float transition2DirectionChange[2];
-    float transition3DirectionChange[2];
-    float transition4DirectionChange[2];
-    Vec2f offset = (Vec2f)nodes[1].getMidpoint() - (Vec2f)nodes[0].getMidpoint();
-    for (int d1 = 0; d1 < 2; ++d1) {
-        float direction = d1 ? 1.0f : -1.0f;
-        simpleT1[d1].rate = direction * curvatureRate;
-        simpleT1[d1].length = (direction * minCurvature - startCurvature) / simpleT1[d1].rate;
-        simpleT2[d1].rate = -simpleT1[d1].rate;
-        simpleT2[d1].length = minCurvature / curvatureRate;
-        simpleT3[d1].rate = direction * curvatureRate;
-        simpleT3[d1].length = minCurvature / curvatureRate;
-        simpleT4[d1].rate = -simpleT3[d1].rate;
-        simpleT4[d1].length = (-endCurvatureRev - direction * minCurvature) / simpleT4[d1].rate;
-
-        uncurvedT1[d1].setStartDirection(nodes[0].getDirection());
-        uncurvedT1[d1].setStartCurvature(startCurvature);
-        uncurvedT1[d1].setCurvatureRate(simpleT1[d1].rate);
-        uncurvedT1[d1].setLength(simpleT1[d1].length);
-        transition1DirectionChange[d1] = uncurvedT1[d1].getEndDirectionChange();
-        // exclude direction change to straighten out
-        float distToStraight = uncurvedT1[d1].lengthAtCurvature(0);
-        if (distToStraight > 0 && distToStraight < simpleT1[d1].length)
-            transition1DirectionChange[d1] -= uncurvedT1[d1].directionChangeAtLength(distToStraight);
-        uncurvedT1[d1] = uncurvedT1[d1].getNextClothoid();
-
-        uncurvedT2[d1].setStartDirection(uncurvedT1[d1].getStartDirection());
-        uncurvedT2[d1].setStartCurvature(uncurvedT1[d1].getStartCurvature());
-        uncurvedT2[d1].setCurvatureRate(-simpleT1[d1].rate);
-        uncurvedT2[d1].setLength(simpleT2[d1].length);
-        transition2DirectionChange[d1] = uncurvedT2[d1].getEndDirectionChange();
-        uncurvedT2[d1] = uncurvedT2[d1].getNextClothoid();
-
-        uncurvedT4rev[d1].setStartDirection(endDirectionRev);
-        uncurvedT4rev[d1].setStartCurvature(endCurvatureRev);
-        uncurvedT4rev[d1].setCurvatureRate(simpleT4[d1].rate);
-        uncurvedT4rev[d1].setLength(simpleT4[d1].length);
-        transition4DirectionChange[d1] = -uncurvedT4rev[d1].getEndDirectionChange();
-        // exclude direction change to straighten out
-        distToStraight = uncurvedT4rev[d1].lengthAtCurvature(0);
-        if (distToStraight > 0 && distToStraight < simpleT4[d1].length)
-            transition4DirectionChange[d1] += uncurvedT4rev[d1].directionChangeAtLength(distToStraight);
-        uncurvedT4rev[d1] = uncurvedT4rev[d1].getNextClothoid();
-
-        uncurvedT3rev[d1].setStartDirection(uncurvedT4rev[d1].getStartDirection());
-        uncurvedT3rev[d1].setStartCurvature(uncurvedT4rev[d1].getStartCurvature());
-        uncurvedT3rev[d1].setCurvatureRate(-simpleT4[d1].rate);
-        uncurvedT3rev[d1].setLength(simpleT3[d1].length);
-        transition3DirectionChange[d1] = -uncurvedT3rev[d1].getEndDirectionChange();
-        uncurvedT3rev[d1] = uncurvedT3rev[d1].getNextClothoid();
-
-        for (int d2 = 0; d2 < 2; ++d2) {
-            float direction2 = d2 ? 1.0f : -1.0f;
-            uncurvedT3[d1][d2].setStartDirection(uncurvedT2[d1].getStartDirection());
-            uncurvedT3[d1][d2].setCurvatureRate(direction2 * curvatureRate);
-            uncurvedT3[d1][d2].setLength(simpleT3[d1].length);
-            uncurvedT3[d1][d2] = uncurvedT3[d1][d2].getNextClothoid();
-
-            uncurvedT2rev[d1][d2].setStartDirection(uncurvedT3rev[d1].getStartDirection());
-            uncurvedT2rev[d1][d2].setCurvatureRate(-direction2 * curvatureRate);
-            uncurvedT2rev[d1][d2].setLength(simpleT2[d1].length);
-            uncurvedT2rev[d1][d2] = uncurvedT2rev[d1][d2].getNextClothoid();
-        }
+    rough = false;
+    if (!cache || !cache->lookup(key, &result)) {
+        // Don't keep drafts or shapes cut short by the time budget
+        rough = !solve(&result.params, &result.dir1, &result.dir2);
+        if (cache && !rough)
+            cache->insert(key, result);
+        flushClothoidPairStats();
     }
 
-    float bestLength = -1;
-    for (int d1 = d1start; d1 < d1end; ++d1) {
-        float dir1 = d1 ? 1.0f : -1.0f;
-        for (int d2 = d2start; d2 < d2end; ++d2) {
-            float dir2 = d2 ? 1.0f : -1.0f;
-            TrackSectionParams params;
-            params.t1 = simpleT1[d1];
-            params.t2 = simpleT2[d1];
-            params.t3 = simpleT3[d2];
-            params.t4 = simpleT4[d2];
-            // Find vector between curve circles
-            Vec2f thisOffset = offset - uncurvedT1[d1].circleAtStart()
-                                    + uncurvedT4rev[d2].circleAtStart();
-            // vector between centers of curve circles when straight = 0
-            Vec2f lineStart = (uncurvedT2[d1].getStartPosition() - (uncurvedT1[d1].circleAtStart() - uncurvedT1[d1].getStartPosition())) +
-                                uncurvedT3[d1][d2].circleAtStart();
-            Vec2f lineNorm2;
-            sincosf(uncurvedT2[d1].getStartDirection(), &lineNorm2[1], &lineNorm2[0]);
-            Vec2f lineNorm3;
-            sincosf(uncurvedT3rev[d2].getStartDirection(), &lineNorm3[1], &lineNorm3[0]);
-            // x = lineStart[0] + s * lineNorm[0]
-            // y = lineStart[1] + s * lineNorm[1]
-            // sqr = x² + y²
-            // sqr = (lineStart[0] + s * lineNorm[0])² + (lineStart[1] + s * lineNorm[1])²
-            // sqr = lineStart[0]² + 2*lineStart[0]*lineNorm[0]*s + lineNorm[0]²*s²
-            //     + lineStart[1]² + 2*lineStart[1]*lineNorm[1]*s + lineNorm[1]²*s²
-            // sqr = lineStart² + 2*(lineStart*lineNorm)*s + s²
-            // a = 1
-            // b = 2*(lineStart*lineNorm)
-            // c = lineStart² - sqr
-            // s = (-b +- sqrt(b²-4ac)) / 2a
-            // s = (-b +- sqrt(b²-4c)) / 2
-            // s = (-2*(lineStart*lineNorm) +- sqrt(4*(lineStart*lineNorm)²-4c)) / 2
-            // s = -(lineStart*lineNorm) +- sqrt((lineStart*lineNorm)²-c)
-            // Curve is angle between straight vector and point of intersection
-            float b = lineStart * lineNorm2;
-            float c = lineStart.sqr() - thisOffset.sqr();
-            float b2m4ac = b*b - c;
-            if (b2m4ac >= 0) {
-                params.s.length = -b + sqrt(b2m4ac);
-                if (params.s.length < 0) {
-                    // Can't shorten the transition curves if swapping direction
-                    if (d1 != d2)
-                        continue;
-                    // TODO reduce t2 & t3 to allow a tighter turn
-                    continue;
-                }
-                // Vector from midpoints of circles when curve=0
-                Vec2f transition2Vec = uncurvedT1[d1].getStartPosition() + uncurvedT2[d1].getStartPosition() - uncurvedT1[d1].circleAtStart();
-                Vec2f transition3Vec = uncurvedT3[d1][d2].circleAtStart();
-                Vec2f transition3VecRev = uncurvedT4rev[d2].getStartPosition() + uncurvedT3rev[d2].getStartPosition() - uncurvedT4rev[d2].circleAtStart();
-                Vec2f transition2VecRev = uncurvedT2rev[d2][d1].circleAtStart();
-                Vec2f midpoint2Vec = transition2Vec + transition3Vec + lineNorm2 * params.s.length;
-                Vec2f midpoint3Vec = -(transition3VecRev + transition2VecRev + lineNorm3 * params.s.length);
-                float angle1 = atan2f(midpoint2Vec[1], midpoint2Vec[0]);
-                float angle2 = atan2f(thisOffset[1], thisOffset[0]);
-                float angle3 = atan2f(midpoint3Vec[1], midpoint3Vec[0]);
-                float curve1 = dir1 * (angle2 - angle1);
-                while (curve1 < 0)
-                    curve1 += M_PI*2;
-                while (curve1 >= M_PI*2)
-                    curve1 -= M_PI*2;
-                params.c1.length = curve1 / minCurvature;
-                float curve2 = dir2 * (angle3 - angle2);
-                while (curve2 < 0)
-                    curve2 += M_PI*2;
-                while (curve2 >= M_PI*2)
-                    curve2 -= M_PI*2;
-                params.c2.length = curve2 / minCurvature;
-
-                float curve1DirectionChange = fabs(transition1DirectionChange[d1] + dir1*curve1 + transition2DirectionChange[d1]);
-                float curve2DirectionChange = fabs(transition3DirectionChange[d2] + dir2*curve2 + transition4DirectionChange[d2]);
-
-                if (unloop1 && curve1DirectionChange > M_PI*2) {
-                    ClothoidT curve1 = uncurvedT1[d1];
-                    curve1.setLength(params.c1.length);
-                    ClothoidT curvedT2 = curve1.getNextClothoid();
-                    curvedT2.setLength(params.t2.length);
-                    curvedT2.setCurvatureRate(params.t2.rate);
-                    ClothoidT curvedS = curvedT2.getNextClothoid();
-
-                    float rate1, len1, rate2, len2, extraStraight;
-                    Vec2f positionB;
-                    if (TrackSection::interpolateClothoidPair(startDirection, startCurvature,
-                                                            curvedS.getStartPosition(),
-                                                            curvedS.getStartDirection(), 0,
-                                                            &rate1, &len1, &rate2, &len2,
-                                                            &positionB, &extraStraight)) {
-                        if (extraStraight > -params.s.length && fabs(rate1) < maxCurvature) {
-                            params.t1.rate = rate1;
-                            params.t1.length = len1;
-                            params.c1.length = 0;
-                            params.t2.rate = rate2;
-                            params.t2.length = len2;
-                            params.s.length += extraStraight;
-                        }
-                    }
-                }
-                if (unloop2 && curve2DirectionChange > M_PI*2) {
-                    ClothoidT curve2 = uncurvedT4rev[d2];
-                    curve2.setLength(params.c2.length);
-                    ClothoidT curvedT3 = curve2.getNextClothoid();
-                    curvedT3.setLength(params.t3.length);
-                    curvedT3.setCurvatureRate(params.t3.rate);
-                    ClothoidT curvedS = curvedT3.getNextClothoid();
-
-                    float rate1, len1, rate2, len2, extraStraight;
-                    Vec2f positionB;
-                    if (TrackSection::interpolateClothoidPair(endDirectionRev, endCurvatureRev,
-                                                            curvedS.getStartPosition(),
-                                                            curvedS.getStartDirection(), 0,
-                                                            &rate1, &len1, &rate2, &len2,
-                                                            &positionB, &extraStraight)) {
-                        if (extraStraight > -params.s.length && fabs(rate1) < maxCurvature) {
-                            params.t4.rate = rate1;
-                            params.t4.length = len1;
-                            params.c2.length = 0;
-                            params.t3.rate = rate2;
-                            params.t3.length = len2;
-                            params.s.length += extraStraight;
-                        }
-                    }
-                }
+    lastDir1 = result.dir1;
+    lastDir2 = result.dir2;
+    buildChain(result.params);
+}
 
-                float length = params.t1.length
-                             + params.c1.length
-                             + params.t2.length
-                             + params.s.length
-                             + params.t3.length
-                             + params.c2.length
-                             + params.t4.length;
-                // For borderline cases, prefer the last chosen directions
-                // This prevents flickering between equally bad possibilities
-                if (d1 == lastDir1 && d2 == lastDir2)
-                    length -= 1;
-                if (bestLength < 0 || length < bestLength) {
-                    bestLength = length;
-                    bestDir1 = d1;
-                    bestDir2 = d2;
-
-                    direction1 = dir1;
-                    direction2 = dir2;
-                    bestParams = params;
-                }
+// Pick the shortest result, or the best so far once the budget is spent
+static bool solveWith(const std::vector<const TrackSectionStrategy *> &strategies,
+                      const TrackSectionStrategy::Problem &problem, float budget,
+                      TrackSectionStrategy::Solution *outBest, bool *outComplete)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    bool found = false;
+    *outComplete = true;
+    for (const TrackSectionStrategy *strategy: strategies) {
+        if (found && budget > 0) {
+            std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - startTime;
+            if (elapsed.count() > budget) {
+                *outComplete = false;
+                break;
             }
         }
+        TrackSectionStrategy::Solution solution;
+        if (strategy->solve(problem, &solution) && (!found || solution.length < outBest->length)) {
+            *outBest = solution;
+            found = true;
+        }
     }
+    return found;
+}
 
-    /* Other routes to attempt for comparison:
-     * 2 clothoids
-     * if d1==d2, negative straight, use double clothoid calculation to replace T2 and T3
-     */
-
-    lastDir1 = bestDir1;
-    lastDir2 = bestDir2;
-    chain.clear();
-
-    ClothoidT *transition1 = chain.append();
-    transition1->setStartPosition((ClothoidT::Vec2l)nodes[0].getMidpoint());
-    transition1->setStartDirection(startDirection);
-    transition1->setStartCurvature(startCurvature);
-
-    transition1->setCurvatureRate(bestParams.t1.rate);
-    transition1->setLength(bestParams.t1.length);
-
-    if (bestParams.c1.length > 0) {
-        ClothoidT *curve1 = chain.append();
-        curve1->setLength(bestParams.c1.length);
+bool TrackSection::solve(TrackSectionParams *outParams,
+                         int *outDir1, int *outDir2) const
+{
+    TrackSectionStrategy::Problem problem;
+    problem.offset = (Vec2f)nodes[1].getMidpoint() - (Vec2f)nodes[0].getMidpoint();
+    problem.startDirection = nodes[0].getDirection();
+    problem.startCurvature = nodes[0].getCurvature();
+    problem.endDirectionRev = nodes[1].getDirection();
+    problem.endCurvatureRev = nodes[1].getCurvature();
+    problem.numTracks = nodes[0].getNumTracks();
+    problem.spec = minSpec;
+    problem.lastDir1 = lastDir1;
+    problem.lastDir2 = lastDir2;
+
+    // While interactive, try reshaping cheaply before searching in full.
+    // Rough shapes are refined without drafts or a time budget.
+    const bool refining = railway && railway->isRefining();
+    TrackSectionStrategy::Solution best;
+    bool found = false, complete = true;
+    if (railway && railway->isInteractive() && !refining) {
+        found = solveWith(TrackSectionStrategy::getDrafts(), problem, 0, &best, &complete);
+        complete = !found;
     }
-
-    if (bestParams.t2.length > 0) {
-        ClothoidT *transition2 = chain.append();
-        transition2->setCurvatureRate(bestParams.t2.rate);
-        transition2->setLength(bestParams.t2.length);
+    if (!found) {
+        found = solveWith(railway ? railway->getInterpolationStrategies()
+                                  : TrackSectionStrategy::getDefaults(),
+                          problem, railway && !refining ? railway->getInterpolationBudget() : 0,
+                          &best, &complete);
     }
 
-    if (bestParams.s.length > 0) {
-        ClothoidT *straight = chain.append();
-        straight->setLength(bestParams.s.length);
+    if (found) {
+        *outParams = best.params;
+        *outDir1 = best.dir1;
+        *outDir2 = best.dir2;
+    } else {
+        *outParams = {};
+        *outDir1 = -1;
+        *outDir2 = -1;
     }
+    return complete;
+}
 
-    if (bestParams.t3.length > 0) {
-        ClothoidT *transition3 = chain.append();
-        transition3->setCurvatureRate(bestParams.t3.rate);
-        transition3->setLength(bestParams.t3.length);
+void TrackSection::buildChain(const TrackSectionParams &bestParams)
+{
+    chain.clear();
+    railLines.clear();
+
+    // Parts of the shape in order, curves and straights having no rate
+    TransitionParams parts[] = {
+        bestParams.t1, {}, bestParams.t2, {}, bestParams.t3, {}, bestParams.t4
+    };
+    parts[1].length = bestParams.c1.length;
+    parts[3].length = bestParams.s.length;
+    parts[5].length = bestParams.c2.length;
+    constexpr unsigned int numParts = sizeof(parts) / sizeof(parts[0]);
+
+    // The first transition may run backwards from the start node, so is
+    // kept unless it's empty
+    ClothoidT *last = nullptr;
+    for (unsigned int i = 0; i < numParts; ++i) {
+        const TransitionParams &part = parts[i];
+        if (i == 0 ? part.length == 0 : !(part.length > 0))
+            continue;
+        last = chain.append();
+        if (chain.clothoids().size() == 1) {
+            last->setStartPosition((ClothoidT::Vec2l)nodes[0].getMidpoint());
+            last->setStartDirection(nodes[0].getDirection());
+            last->setStartCurvature(nodes[0].getCurvature());
+        }
+        last->setCurvatureRate(part.rate);
+        last->setLength(part.length);
+    }
+    if (!last) {
+        // No shape, so just the start node
+        ClothoidT *start = chain.append();
+        start->setStartPosition((ClothoidT::Vec2l)nodes[0].getMidpoint());
+        start->setStartDirection(nodes[0].getDirection());
+        start->setStartCurvature(nodes[0].getCurvature());
     }
 
-    if (bestParams.c2.length > 0) {
-        ClothoidT *curve2 = chain.append();
-        curve2->setLength(bestParams.c2.length);
+    // Marks the end of the chain
+    chain.append();
+
+    updateBounds();
+}
+
+void TrackSection::updateBounds()
+{
+    // Parallel lines between two offsets lie between the outermost ones.
+    // Tracks are included symmetrically to allow for either offset sign.
+    float maxOffset = 0;
+    const int numRails = minSpec->getTrackGauge()->getNumRails();
+    for (int track = 0; track < nodes[0].getNumTracks(); ++track) {
+        float offset = nodes[0].getTrackOffset(track) - nodes[0].getMidpointOffset();
+        maxOffset = std::max(maxOffset, fabsf(offset));
+        for (int rail = 0; rail < numRails; ++rail) {
+            float railOffset = offset - minSpec->getTrackGauge()->getRailPosition(rail)[0];
+            maxOffset = std::max(maxOffset, fabsf(railOffset));
+        }
     }
 
-    if (bestParams.t4.length > 0) {
-        ClothoidT *transition4 = chain.append();
-        transition4->setCurvatureRate(bestParams.t4.rate);
-        transition4->setLength(bestParams.t4.length);
+    // Tolerance well within the tightest allowed curves
+    const float tolerance = std::min(0.5f, 0.1f / minSpec->getMaxCurvature());
+    bounds = Box2f();
+    for (const ClothoidT &clothoid: chain.clothoids()) {
+        // Including a first transition running backwards from the start
+        if (clothoid.getLength() == 0)
+            continue;
+        bounds.include(clothoid.parallelBounds(-maxOffset, tolerance));
+        bounds.include(clothoid.parallelBounds(maxOffset, tolerance));
     }
+}
 
-    ClothoidT *end = chain.append();
+void TrackSection::tessellateRails()
+{
+    const int numRails = minSpec->getTrackGauge()->getNumRails();
+    railLines.clear();
+    railLines.resize(nodes[0].getNumTracks() * numRails);
+
+    for (int track = 0; track < nodes[0].getNumTracks(); ++track) {
+        float offset = nodes[0].getTrackOffset(track) - nodes[0].getMidpointOffset();
+        for (int rail = 0; rail < numRails; ++rail) {
+            float railOffset = offset - minSpec->getTrackGauge()->getRailPosition(rail)[0];
+            std::vector<RailVertex> &line = railLines[track * numRails + rail];
+            for (const ClothoidT &clothoid: chain.clothoids()) {
+                if (!clothoid.getLength())
+                    continue;
+                // Each clothoid starts where the last one ended. A first
+                // transition of negative length is drawn back from the start.
+                float len = line.empty() ? 0 : clothoid.parallelTessellationStep(railOffset, 0,
+                                                         railTessellationTolerance);
+                for (;;) {
+                    line.push_back({ clothoid.parallelPositionAtLength(railOffset, len),
+                                     clothoid.parallelCurvatureAtLength(offset, len) });
+                    if (clothoid.isAtEnd(len))
+                        break;
+                    len += clothoid.parallelTessellationStep(railOffset, len,
+                                                             railTessellationTolerance);
+                }
+            }
+        }
+    }
 }
 
 void TrackSection::notifyNodeChanged(TrackNode *node)
 {
-    interpolate();
+    if (railway)
+        railway->markDirty(this);
+    else
+        interpolate();
 }
@@ -1,20 +1,66 @@
 #ifndef TRAINS_TRACK_SECTION_H
 #define TRAINS_TRACK_SECTION_H
 
+#include "BoundingBox.h"
 #include "Renderable.h"
 #include "TrackNode.h"
+#include "TrackSectionParams.h"
 #include "ClothoidChain.h"
 
 #include <list>
+#include <vector>
 
+class Railway;
+class TrackSection;
 class TrackSpec;
 
+typedef SlotId<TrackSection> SectionId;
+
 class TrackSection : public Renderable
 {
-private:
+public:
     typedef ClothoidChain<float, float> ClothoidChainT;
+    // Cached location for sequential position queries
+    typedef ClothoidChainT::Cursor Cursor;
+
+    // Convergence of the clothoid pair solver used to unloop curves
+    struct ClothoidPairStats {
+        static constexpr unsigned int maxIterations = 32;
+        enum Outcome {
+            Converged,
+            // No pair of clothoids turns through the direction change
+            FailureNoPair,
+            // Steps stopped changing the curvature rate short of the line
+            FailureStalled,
+            // Still not on the line after maxIterations
+            FailureIterations,
+            NumOutcomes
+        };
+
+        unsigned long calls;
+        unsigned long iterations;
+        // Calls by outcome
+        unsigned long outcomes[NumOutcomes];
+        // Converged calls by number of iterations taken
+        unsigned long iterationCounts[maxIterations + 1];
+    };
+
+private:
     typedef ClothoidChainT::Clothoid ClothoidT;
     typedef ClothoidT::Mat22l Mat22f;
+    // Faster approximate evaluation for rendering
+    typedef Clothoid<float, float, FresnelTable> RenderClothoidT;
+
+    // Railway deferring interpolation, or nullptr to interpolate immediately
+    Railway *railway;
+    // Handle of the section in the railway
+    SectionId id;
+    // Whether the railway has this queued for interpolation
+    bool interpolationPending;
+    // Whether the shape is a draft or was cut short, to be refined later
+    bool rough;
+    // Whether the railway has this listed as rough
+    bool roughListed;
 
     // Minimum track specifications
     const TrackSpec *minSpec;
@@ -28,6 +74,19 @@ private:
     // Last chosen directions of 2 curves
     int lastDir1, lastDir2;
 
+    // Box containing all tracks and rails, updated by interpolate()
+    Box2f bounds;
+
+    // Maximum distance of rendered rails from the true curve
+    static constexpr float railTessellationTolerance = 0.01f;
+    struct RailVertex {
+        Vec2f position;
+        // Curvature of the track, for colouring
+        float curvature;
+    };
+    // Polylines of each rail of each track, built on demand after interpolate()
+    std::vector<std::vector<RailVertex>> railLines;
+
 public:
     // Constructor
     TrackSection(TrackNode::Reference start,
@@ -55,28 +114,100 @@ public:
         return nodes[1];
     }
 
+    const Box2f &getBounds() const
+    {
+        return bounds;
+    }
+
     float getLength(int trackIndex) const;
     Vec3f getPosition(int trackIndex, float distance,
                       Mat22f *outRotMatrix = nullptr) const;
+    Vec3f getPosition(Cursor *cursor, int trackIndex, float distance,
+                      Mat22f *outRotMatrix = nullptr) const;
+    // Find the track passing closest to point, the distance along it and
+    // how far point is from it. Returns false if there is no track shape.
+    bool findClosestPoint(const Vec2f &point, int *outTrackIndex,
+                          float *outDistance, float *outSeparation) const;
+
+    void setRailway(Railway *newRailway, SectionId newId)
+    {
+        railway = newRailway;
+        id = newId;
+    }
+    SectionId getId() const
+    {
+        return id;
+    }
+    bool isInterpolationPending() const
+    {
+        return interpolationPending;
+    }
+    void setInterpolationPending(bool pending)
+    {
+        interpolationPending = pending;
+    }
+    bool isRough() const
+    {
+        return rough;
+    }
+    bool isRoughListed() const
+    {
+        return roughListed;
+    }
+    void setRoughListed(bool listed)
+    {
+        roughListed = listed;
+    }
 
     // Notifications of node changes
     void notifyNodeChanged(TrackNode *node);
 
+    // Totals over all sections since the last reset
+    static ClothoidPairStats getClothoidPairStats();
+    static void resetClothoidPairStats();
+
+    // Join a curve onto a straight line with a pair of opposite transitions
+    static bool interpolateClothoidPair(float directionA, float curvatureA,
+                                        const Vec2f &positionB, float directionB,
+                                        float curvatureB,
+                                        float *outRate1, float *outLen1,
+                                        float *outRate2, float *outLen2,
+                                        Vec2f *outB, float *outExtraStraight);
+    // Join a curve onto a circle with a pair of opposite transitions
+    static bool interpolateClothoidPairToCurve(float directionA, float curvatureA,
+                                               const Vec2f &positionB, float directionB,
+                                               float curvatureB,
+                                               float *outRate1, float *outLen1,
+                                               float *outRate2, float *outLen2,
+                                               float *outExtraCurve);
+
     RENDERABLE_GL();
 
 private:
 
+    // Find the best track shape between the nodes with the railway's
+    // strategies, returning false if only a draft was made or the time
+    // budget cut the search short
+    bool solve(TrackSectionParams *outParams, int *outDir1, int *outDir2) const;
+    // Build the clothoid chain from the start node with a track shape,
+    // dropping empty parts other than the first transition
+    void buildChain(const TrackSectionParams &params);
+    // Find bounds for the current track shape
+    void updateBounds();
+    // Build railLines for the current track shape
+    void tessellateRails();
+
     static bool calcImpliedFromCurvatureRateAC(float directionDelta,
                                                float curvatureA, float curvatureB,
                                                float curvatureRateAC,
                                                float *outCurvatureRateCB,
                                                float *outLengthAC, float *outLengthCB);
-    static bool interpolateClothoidPair(float directionA, float curvatureA,
-                                        const Vec2f &positionB, float directionB,
-                                        float curvatureB,
-                                        float *outRate1, float *outLen1,
-                                        float *outRate2, float *outLen2,
-                                        Vec2f *outB, float *outExtraStraight);
+    static bool evaluateClothoidPair(float directionA, float curvatureA,
+                                     float directionDelta, float curvatureB,
+                                     float curvatureRateAC,
+                                     float *outCurvatureRateCB,
+                                     float *outLengthAC, float *outLengthCB,
+                                     Vec2f *outPosition, Vec2f *outDerivative);
 };
 
 #endif // TRAINS_TRACK_SECTION_H
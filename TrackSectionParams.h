@@ -0,0 +1,22 @@
+#ifndef TRAINS_TRACK_SECTION_PARAMS_H
+#define TRAINS_TRACK_SECTION_PARAMS_H
+
+// Shape of a track section, independent of its position and direction
+
+struct SegmentParams {
+    float length;
+};
+struct TransitionParams : public SegmentParams {
+    float rate;
+};
+
+struct TrackSectionParams {
+    // Transition curves
+    TransitionParams t1, t2, t3, t4;
+    // Fixed curves
+    SegmentParams c1, c2;
+    // Straights
+    SegmentParams s;
+};
+
+#endif // TRAINS_TRACK_SECTION_PARAMS_H
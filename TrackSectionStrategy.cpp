@@ -0,0 +1,588 @@
+#include "TrackSectionStrategy.h"
+#include "ClothoidPacket.h"
+#include "TrackSection.h"
+#include "TrackSpec.h"
+#include "TransitionTemplate.h"
+
+#include <cmath>
+
+typedef TrackSection::ClothoidChainT::Clothoid ClothoidT;
+
+// Rotate a vector from east to face forward
+static Vec2f rotate(const Vec2f &vec, const Vec2f &forward)
+{
+    return Vec2f(forward[0] * vec[0] - forward[1] * vec[1],
+                 forward[1] * vec[0] + forward[0] * vec[1]);
+}
+
+// Turn a template clothoid about the origin from east to face direction
+static TransitionTemplate::ClothoidT orient(const TransitionTemplate::ClothoidT &clothoid,
+                                            const Vec2f &forward, float direction)
+{
+    TransitionTemplate::ClothoidT ret = clothoid;
+    ret.setStartPosition(rotate(clothoid.getStartPosition(), forward));
+    ret.setStartDirection(clothoid.getStartDirection() + direction);
+    return ret;
+}
+
+namespace {
+    /*
+     * Transitions from each end into curves of the preferred curvature,
+     * joined by a straight, trying each direction of each curve. Curves
+     * which would loop right round are replaced by a clothoid pair.
+     */
+    class CurvesStrategy : public TrackSectionStrategy
+    {
+    public:
+        const char *getName() const override
+        {
+            return "curves";
+        }
+
+        bool solve(const Problem &problem, Solution *outSolution) const override;
+    };
+}
+
+bool CurvesStrategy::solve(const Problem &problem, Solution *outSolution) const
+{
+    constexpr bool unloop1 = true;
+    constexpr bool unloop2 = true;
+    constexpr int d1start = 0;
+    constexpr int d1end = 2;
+    constexpr int d2start = 0;
+    constexpr int d2end = 2;
+
+    const float maxCurvature = problem.spec->getMaxCurvature();
+    const float startDirection = problem.startDirection;
+    const float startCurvature = problem.startCurvature;
+    const float endDirectionRev = problem.endDirectionRev;
+    const float endCurvatureRev = problem.endCurvatureRev;
+
+    int bestDir1 = -1, bestDir2 = -1;
+
+    // If multiple tracks to right, reduce curvature accordingly
+    const unsigned int numTracks = problem.numTracks;
+    const float minCurvature = problem.spec->getMinCurvature(numTracks);
+
+    TrackSectionParams bestParams = {};
+
+    // Transitions at each end, shared with other sections of the same spec
+    const TransitionTemplate startTemplate =
+        problem.spec->getTransitionTemplate(startCurvature, numTracks);
+    const TransitionTemplate endTemplate =
+        problem.spec->getTransitionTemplate(endCurvatureRev, numTracks);
+    Vec2f startForward, endForward;
+    sincosf(startDirection, &startForward[1], &startForward[0]);
+    sincosf(endDirectionRev, &endForward[1], &endForward[0]);
+
+    // individual clothoids excluding the curves and straights
+    ClothoidPacket<2> uncurvedT1; // from start to first curve
+    ClothoidT uncurvedT2[2]; // from first curve to straight
+    Vec2f uncurvedT3Circle[2][2]; // second curve after straight
+    ClothoidPacket<2> uncurvedT4rev; // from end to second curve
+    ClothoidT uncurvedT3rev[2]; // from second curve to straight
+    Vec2f uncurvedT2revCircle[2][2]; // first curve before straight
+
+    // Indexed by d1
+    TransitionParams simpleT1[2], simpleT2[2];
+    // Indexed by d2
+    TransitionParams simpleT3[2], simpleT4[2];
+    float transition1DirectionChange[2];
+    float transition2DirectionChange[2];
+    float transition3DirectionChange[2];
+    float transition4DirectionChange[2];
+    const Vec2f &offset = problem.offset;
+    for (int d1 = 0; d1 < 2; ++d1) {
+        simpleT1[d1] = startTemplate.toCurve[d1];
+        simpleT2[d1] = startTemplate.fromCurve[d1];
+        transition1DirectionChange[d1] = startTemplate.toCurveDirectionChange[d1];
+        transition2DirectionChange[d1] = startTemplate.fromCurveDirectionChange[d1];
+        uncurvedT1.set(d1, orient(startTemplate.curve[d1], startForward, startDirection));
+        uncurvedT2[d1] = orient(startTemplate.straight[d1], startForward, startDirection);
+
+        // The end transitions are reversed, so curve the opposite way
+        simpleT4[d1] = endTemplate.toCurve[!d1];
+        simpleT3[d1] = endTemplate.fromCurve[!d1];
+        transition4DirectionChange[d1] = -endTemplate.toCurveDirectionChange[!d1];
+        transition3DirectionChange[d1] = -endTemplate.fromCurveDirectionChange[!d1];
+        uncurvedT4rev.set(d1, orient(endTemplate.curve[!d1], endForward, endDirectionRev));
+        uncurvedT3rev[d1] = orient(endTemplate.straight[!d1], endForward, endDirectionRev);
+
+        Vec2f forward2, forward3;
+        sincosf(uncurvedT2[d1].getStartDirection(), &forward2[1], &forward2[0]);
+        sincosf(uncurvedT3rev[d1].getStartDirection(), &forward3[1], &forward3[0]);
+        for (int d2 = 0; d2 < 2; ++d2) {
+            uncurvedT3Circle[d1][d2] = rotate(startTemplate.straightToCurveCircle[d2],
+                                              forward2);
+            uncurvedT2revCircle[d1][d2] = rotate(endTemplate.straightToCurveCircle[!d2],
+                                                 forward3);
+        }
+    }
+    Vec2f uncurvedT1Circle[2], uncurvedT4revCircle[2];
+    uncurvedT1.circlesAtStart(uncurvedT1Circle);
+    uncurvedT4rev.circlesAtStart(uncurvedT4revCircle);
+
+    // Candidates are indexed by d1*2 + d2, and evaluated in lockstep
+    TrackSectionParams candidates[4] = {};
+    bool valid[4] = {};
+    bool loops1[4] = {}, loops2[4] = {};
+    bool anyLoops1 = false, anyLoops2 = false;
+    for (int d1 = d1start; d1 < d1end; ++d1) {
+        float dir1 = d1 ? 1.0f : -1.0f;
+        for (int d2 = d2start; d2 < d2end; ++d2) {
+            float dir2 = d2 ? 1.0f : -1.0f;
+            TrackSectionParams &params = candidates[d1*2 + d2];
+            params.t1 = simpleT1[d1];
+            params.t2 = simpleT2[d1];
+            params.t3 = simpleT3[d2];
+            params.t4 = simpleT4[d2];
+            // Find vector between curve circles
+            Vec2f thisOffset = offset - uncurvedT1Circle[d1] + uncurvedT4revCircle[d2];
+            // vector between centers of curve circles when straight = 0
+            Vec2f lineStart = (uncurvedT2[d1].getStartPosition() - (uncurvedT1Circle[d1] - uncurvedT1.getStartPosition(d1))) +
+                                uncurvedT3Circle[d1][d2];
+            Vec2f lineNorm2;
+            sincosf(uncurvedT2[d1].getStartDirection(), &lineNorm2[1], &lineNorm2[0]);
+            Vec2f lineNorm3;
+            sincosf(uncurvedT3rev[d2].getStartDirection(), &lineNorm3[1], &lineNorm3[0]);
+            // x = lineStart[0] + s * lineNorm[0]
+            // y = lineStart[1] + s * lineNorm[1]
+            // sqr = x² + y²
+            // sqr = (lineStart[0] + s * lineNorm[0])² + (lineStart[1] + s * lineNorm[1])²
+            // sqr = lineStart[0]² + 2*lineStart[0]*lineNorm[0]*s + lineNorm[0]²*s²
+            //     + lineStart[1]² + 2*lineStart[1]*lineNorm[1]*s + lineNorm[1]²*s²
+            // sqr = lineStart² + 2*(lineStart*lineNorm)*s + s²
+            // a = 1
+            // b = 2*(lineStart*lineNorm)
+            // c = lineStart² - sqr
+            // s = (-b +- sqrt(b²-4ac)) / 2a
+            // s = (-b +- sqrt(b²-4c)) / 2
+            // s = (-2*(lineStart*lineNorm) +- sqrt(4*(lineStart*lineNorm)²-4c)) / 2
+            // s = -(lineStart*lineNorm) +- sqrt((lineStart*lineNorm)²-c)
+            // Curve is angle between straight vector and point of intersection
+            float b = lineStart * lineNorm2;
+            float c = lineStart.sqr() - thisOffset.sqr();
+            float b2m4ac = b*b - c;
+            if (b2m4ac < 0)
+                continue;
+            params.s.length = -b + sqrt(b2m4ac);
+            if (params.s.length < 0) {
+                // Can't shorten the transition curves if swapping direction
+                if (d1 != d2)
+                    continue;
+                // TODO reduce t2 & t3 to allow a tighter turn
+                continue;
+            }
+            // Vector from midpoints of circles when curve=0
+            Vec2f transition2Vec = uncurvedT1.getStartPosition(d1) + uncurvedT2[d1].getStartPosition() - uncurvedT1Circle[d1];
+            Vec2f transition3Vec = uncurvedT3Circle[d1][d2];
+            Vec2f transition3VecRev = uncurvedT4rev.getStartPosition(d2) + uncurvedT3rev[d2].getStartPosition() - uncurvedT4revCircle[d2];
+            Vec2f transition2VecRev = uncurvedT2revCircle[d2][d1];
+            Vec2f midpoint2Vec = transition2Vec + transition3Vec + lineNorm2 * params.s.length;
+            Vec2f midpoint3Vec = -(transition3VecRev + transition2VecRev + lineNorm3 * params.s.length);
+            float angle1 = atan2f(midpoint2Vec[1], midpoint2Vec[0]);
+            float angle2 = atan2f(thisOffset[1], thisOffset[0]);
+            float angle3 = atan2f(midpoint3Vec[1], midpoint3Vec[0]);
+            float curve1 = dir1 * (angle2 - angle1);
+            while (curve1 < 0)
+                curve1 += M_PI*2;
+            while (curve1 >= M_PI*2)
+                curve1 -= M_PI*2;
+            params.c1.length = curve1 / minCurvature;
+            float curve2 = dir2 * (angle3 - angle2);
+            while (curve2 < 0)
+                curve2 += M_PI*2;
+            while (curve2 >= M_PI*2)
+                curve2 -= M_PI*2;
+            params.c2.length = curve2 / minCurvature;
+
+            float curve1DirectionChange = fabs(transition1DirectionChange[d1] + dir1*curve1 + transition2DirectionChange[d1]);
+            float curve2DirectionChange = fabs(transition3DirectionChange[d2] + dir2*curve2 + transition4DirectionChange[d2]);
+            valid[d1*2 + d2] = true;
+            loops1[d1*2 + d2] = unloop1 && curve1DirectionChange > M_PI*2;
+            loops2[d1*2 + d2] = unloop2 && curve2DirectionChange > M_PI*2;
+            anyLoops1 = anyLoops1 || loops1[d1*2 + d2];
+            anyLoops2 = anyLoops2 || loops2[d1*2 + d2];
+        }
+    }
+
+    // Find where each looping candidate's curve reaches the straight, and
+    // replace its transitions and curve with a clothoid pair onto it
+    if (anyLoops1) {
+        ClothoidPacket<4> curve1;
+        for (int i = 0; i < 4; ++i) {
+            if (loops1[i]) {
+                curve1.set(i, uncurvedT1.get(i / 2));
+                curve1.length[i] = candidates[i].c1.length;
+            }
+        }
+        ClothoidPacket<4> curvedT2 = curve1.getNextClothoids();
+        for (int i = 0; i < 4; ++i) {
+            curvedT2.length[i] = candidates[i].t2.length;
+            curvedT2.curvatureRate[i] = candidates[i].t2.rate;
+        }
+        ClothoidPacket<4> curvedS = curvedT2.getNextClothoids();
+        for (int i = 0; i < 4; ++i) {
+            if (!loops1[i])
+                continue;
+            TrackSectionParams &params = candidates[i];
+            float rate1, len1, rate2, len2, extraStraight;
+            Vec2f positionB;
+            if (TrackSection::interpolateClothoidPair(startDirection, startCurvature,
+                                                    curvedS.getStartPosition(i),
+                                                    curvedS.startDirection[i], 0,
+                                                    &rate1, &len1, &rate2, &len2,
+                                                    &positionB, &extraStraight)) {
+                if (extraStraight > -params.s.length && fabs(rate1) < maxCurvature) {
+                    params.t1.rate = rate1;
+                    params.t1.length = len1;
+                    params.c1.length = 0;
+                    params.t2.rate = rate2;
+                    params.t2.length = len2;
+                    params.s.length += extraStraight;
+                }
+            }
+        }
+    }
+    if (anyLoops2) {
+        ClothoidPacket<4> curve2;
+        for (int i = 0; i < 4; ++i) {
+            if (loops2[i]) {
+                curve2.set(i, uncurvedT4rev.get(i % 2));
+                curve2.length[i] = candidates[i].c2.length;
+            }
+        }
+        ClothoidPacket<4> curvedT3 = curve2.getNextClothoids();
+        for (int i = 0; i < 4; ++i) {
+            curvedT3.length[i] = candidates[i].t3.length;
+            curvedT3.curvatureRate[i] = candidates[i].t3.rate;
+        }
+        ClothoidPacket<4> curvedS = curvedT3.getNextClothoids();
+        for (int i = 0; i < 4; ++i) {
+            if (!loops2[i])
+                continue;
+            TrackSectionParams &params = candidates[i];
+            float rate1, len1, rate2, len2, extraStraight;
+            Vec2f positionB;
+            if (TrackSection::interpolateClothoidPair(endDirectionRev, endCurvatureRev,
+                                                    curvedS.getStartPosition(i),
+                                                    curvedS.startDirection[i], 0,
+                                                    &rate1, &len1, &rate2, &len2,
+                                                    &positionB, &extraStraight)) {
+                if (extraStraight > -params.s.length && fabs(rate1) < maxCurvature) {
+                    params.t4.rate = rate1;
+                    params.t4.length = len1;
+                    params.c2.length = 0;
+                    params.t3.rate = rate2;
+                    params.t3.length = len2;
+                    params.s.length += extraStraight;
+                }
+            }
+        }
+    }
+
+    float bestLength = -1;
+    for (int i = 0; i < 4; ++i) {
+        if (!valid[i])
+            continue;
+        const TrackSectionParams &params = candidates[i];
+        int d1 = i / 2, d2 = i % 2;
+        float length = params.t1.length
+                     + params.c1.length
+                     + params.t2.length
+                     + params.s.length
+                     + params.t3.length
+                     + params.c2.length
+                     + params.t4.length;
+        // For borderline cases, prefer the last chosen directions
+        // This prevents flickering between equally bad possibilities
+        if (d1 == problem.lastDir1 && d2 == problem.lastDir2)
+            length -= 1;
+        if (bestLength < 0 || length < bestLength) {
+            bestLength = length;
+            bestDir1 = d1;
+            bestDir2 = d2;
+            bestParams = params;
+        }
+    }
+
+    /* Other routes to attempt for comparison:
+     * if d1==d2, negative straight, use double clothoid calculation to replace T2 and T3
+     */
+
+    if (bestLength < 0)
+        return false;
+    outSolution->params = bestParams;
+    outSolution->dir1 = bestDir1;
+    outSolution->dir2 = bestDir2;
+    outSolution->length = bestLength;
+    return true;
+}
+
+
+namespace {
+    /*
+     * A pair of opposite transitions from one end onto the line or circle
+     * through the other end, then along that fixed straight or curve to the
+     * end.
+     */
+    class ClothoidPairStrategy : public TrackSectionStrategy
+    {
+    public:
+        const char *getName() const override
+        {
+            return "clothoid pair";
+        }
+
+        bool solve(const Problem &problem, Solution *outSolution) const override;
+    };
+
+    /*
+     * Two circular arcs meeting tangentially halfway between their control
+     * points, a closed form draft while dragging. Curvature jumps between
+     * the arcs and at the nodes, so the arcs are joined by very short
+     * transitions, and the curvature rate limits of the spec are ignored.
+     */
+    class BiarcStrategy : public TrackSectionStrategy
+    {
+    public:
+        const char *getName() const override
+        {
+            return "biarc";
+        }
+
+        bool solve(const Problem &problem, Solution *outSolution) const override;
+    };
+
+    /*
+     * A single transition, only possible when the ends happen to line up,
+     * such as a straight between nodes facing each other.
+     */
+    class SingleClothoidStrategy : public TrackSectionStrategy
+    {
+    public:
+        const char *getName() const override
+        {
+            return "single clothoid";
+        }
+
+        bool solve(const Problem &problem, Solution *outSolution) const override;
+    };
+}
+
+bool ClothoidPairStrategy::solve(const Problem &problem, Solution *outSolution) const
+{
+    // Within the same limits as the curves
+    const float maxCurvatureRate = problem.spec->getMinCurvatureRate();
+    const float maxCurvature = problem.spec->getMinCurvature(problem.numTracks);
+
+    bool found = false;
+    for (int reverse = 0; reverse < 2; ++reverse) {
+        // Turn from one end onto the line or circle through the other, away
+        // from it
+        float directionA, curvatureA, directionB, curvatureB;
+        Vec2f positionB;
+        if (!reverse) {
+            directionA = problem.startDirection;
+            curvatureA = problem.startCurvature;
+            positionB = problem.offset;
+            directionB = problem.endDirectionRev + M_PI;
+            curvatureB = -problem.endCurvatureRev;
+        } else {
+            directionA = problem.endDirectionRev;
+            curvatureA = problem.endCurvatureRev;
+            positionB = -problem.offset;
+            directionB = problem.startDirection + M_PI;
+            curvatureB = -problem.startCurvature;
+        }
+
+        // The rest of the way follows the other end's straight or curve
+        float rate1, len1, rate2, len2, extra;
+        if (!curvatureB) {
+            Vec2f pairEnd;
+            if (!TrackSection::interpolateClothoidPair(directionA, curvatureA,
+                                                       positionB, directionB, 0,
+                                                       &rate1, &len1, &rate2, &len2,
+                                                       &pairEnd, &extra))
+                continue;
+        } else if (!TrackSection::interpolateClothoidPairToCurve(directionA, curvatureA,
+                                                                 positionB, directionB,
+                                                                 curvatureB,
+                                                                 &rate1, &len1,
+                                                                 &rate2, &len2, &extra)) {
+            continue;
+        }
+        if (extra < 0 || fabs(rate1) > maxCurvatureRate ||
+            fabs(curvatureA + rate1 * len1) > maxCurvature)
+            continue;
+
+        float length = len1 + len2 + extra;
+        if (found && length >= outSolution->length)
+            continue;
+        found = true;
+        outSolution->params = {};
+        // Reversed clothoids keep the same curvature rate
+        TransitionParams &first = reverse ? outSolution->params.t4 : outSolution->params.t1;
+        TransitionParams &second = reverse ? outSolution->params.t3 : outSolution->params.t2;
+        first.rate = rate1;
+        first.length = len1;
+        second.rate = rate2;
+        second.length = len2;
+        if (!curvatureB)
+            outSolution->params.s.length = extra;
+        else if (!reverse)
+            outSolution->params.c2.length = extra;
+        else
+            outSolution->params.c1.length = extra;
+        outSolution->dir1 = -1;
+        outSolution->dir2 = -1;
+        outSolution->length = length;
+    }
+    return found;
+}
+
+// Find the circular arc leaving the origin along unit vector tangent which
+// passes through chord, returning false if it would nearly turn right round
+static bool arcThrough(const Vec2f &tangent, const Vec2f &chord,
+                       float *outCurvature, float *outLength, float *outTurn)
+{
+    const float chordLength = chord.mag();
+    if (!chordLength) {
+        *outCurvature = 0;
+        *outLength = 0;
+        *outTurn = 0;
+        return true;
+    }
+    // The arc turns through twice the angle between tangent and chord
+    const float halfTurn = atan2f(tangent[0] * chord[1] - tangent[1] * chord[0],
+                                  tangent * chord);
+    if (fabsf(halfTurn) > M_PI*0.9f)
+        return false;
+    const float sinHalfTurn = sinf(halfTurn);
+    *outCurvature = 2 * sinHalfTurn / chordLength;
+    *outLength = halfTurn ? chordLength * halfTurn / sinHalfTurn : chordLength;
+    *outTurn = 2 * halfTurn;
+    return true;
+}
+
+bool BiarcStrategy::solve(const Problem &problem, Solution *outSolution) const
+{
+    // Length of the transitions standing in for curvature jumps
+    constexpr float jumpLength = 1e-3f;
+
+    const Vec2f &offset = problem.offset;
+    Vec2f startForward, endForward;
+    sincosf(problem.startDirection, &startForward[1], &startForward[0]);
+    // Direction of travel at the end
+    sincosf(problem.endDirectionRev + M_PI, &endForward[1], &endForward[0]);
+
+    // Distance d of both control points from their ends, such that they're
+    // 2d apart: 2(1 - t0.t1)d² + 2(v.t)d - v² = 0 with t = t0 + t1
+    const float vt = offset * (startForward + endForward);
+    const float oneMinusCos = 1 - startForward * endForward;
+    const float denominator = vt + sqrtf(vt*vt + 2 * oneMinusCos * offset.sqr());
+    if (!(denominator > 0))
+        return false;
+    const float d = offset.sqr() / denominator;
+    // Control points further out than the nodes are apart mean the arcs
+    // nearly loop round, which the full strategies shape better
+    if (!(d <= offset.mag()))
+        return false;
+    // The arcs meet halfway between the control points
+    const Vec2f join = (offset + (startForward - endForward) * d) * 0.5f;
+
+    float curvature1, length1, turn1;
+    if (!arcThrough(startForward, join, &curvature1, &length1, &turn1))
+        return false;
+    Vec2f joinForward;
+    sincosf(problem.startDirection + turn1, &joinForward[1], &joinForward[0]);
+    float curvature2, length2, turn2;
+    if (!arcThrough(joinForward, offset - join, &curvature2, &length2, &turn2))
+        return false;
+    const float maxCurvature = problem.spec->getMaxCurvature();
+    if (fabsf(curvature1) > maxCurvature || fabsf(curvature2) > maxCurvature)
+        return false;
+
+    const float endCurvature = -problem.endCurvatureRev;
+    TrackSectionParams &params = outSolution->params;
+    params = {};
+    params.t1.rate = (curvature1 - problem.startCurvature) / jumpLength;
+    params.t1.length = jumpLength;
+    params.c1.length = length1;
+    params.t2.rate = (curvature2 - curvature1) / jumpLength;
+    params.t2.length = jumpLength;
+    params.c2.length = length2;
+    params.t4.rate = (endCurvature - curvature2) / jumpLength;
+    params.t4.length = jumpLength;
+    // Keep the previous curve directions for when the shape is refined
+    outSolution->dir1 = problem.lastDir1;
+    outSolution->dir2 = problem.lastDir2;
+    outSolution->length = length1 + length2 + 3 * jumpLength;
+    return true;
+}
+
+bool SingleClothoidStrategy::solve(const Problem &problem, Solution *outSolution) const
+{
+    // How closely the end must be reached
+    constexpr float positionTolerance = 1e-3f;
+    constexpr float directionTolerance = 1e-4f;
+
+    const float endCurvature = -problem.endCurvatureRev;
+    const float directionDelta = remainderf(problem.endDirectionRev + M_PI
+                                            - problem.startDirection, M_PI*2);
+    // The direction changes by the length times the mean curvature
+    const float curvatureSum = problem.startCurvature + endCurvature;
+    float length;
+    if (curvatureSum) {
+        length = directionDelta * 2 / curvatureSum;
+    } else if (!problem.startCurvature && fabs(directionDelta) < directionTolerance) {
+        // Straight
+        Vec2f forward;
+        sincosf(problem.startDirection, &forward[1], &forward[0]);
+        length = problem.offset * forward;
+    } else {
+        return false;
+    }
+    if (!(length > 0))
+        return false;
+    const float rate = (endCurvature - problem.startCurvature) / length;
+    if (fabs(rate) > problem.spec->getMinCurvatureRate())
+        return false;
+
+    ClothoidT clothoid;
+    clothoid.setStartDirection(problem.startDirection);
+    clothoid.setStartCurvature(problem.startCurvature);
+    clothoid.setCurvatureRate(rate);
+    clothoid.setLength(length);
+    if ((clothoid.getEndPosition() - problem.offset).sqr() >
+            positionTolerance * positionTolerance)
+        return false;
+
+    outSolution->params = {};
+    outSolution->params.t1.rate = rate;
+    outSolution->params.t1.length = length;
+    outSolution->dir1 = -1;
+    outSolution->dir2 = -1;
+    outSolution->length = length;
+    return true;
+}
+
+const std::vector<const TrackSectionStrategy *> &TrackSectionStrategy::getDefaults()
+{
+    static const CurvesStrategy curves;
+    static const ClothoidPairStrategy clothoidPair;
+    static const SingleClothoidStrategy singleClothoid;
+    static const std::vector<const TrackSectionStrategy *> defaults = {
+        &curves, &clothoidPair, &singleClothoid
+    };
+    return defaults;
+}
+
+const std::vector<const TrackSectionStrategy *> &TrackSectionStrategy::getDrafts()
+{
+    static const BiarcStrategy biarc;
+    static const std::vector<const TrackSectionStrategy *> drafts = {
+        &biarc
+    };
+    return drafts;
+}
@@ -0,0 +1,53 @@
+#ifndef TRAINS_TRACK_SECTION_STRATEGY_H
+#define TRAINS_TRACK_SECTION_STRATEGY_H
+
+#include "TrackSectionParams.h"
+#include "Vector.h"
+
+#include <vector>
+
+class TrackSpec;
+
+// An algorithm for shaping a track section between its end nodes
+class TrackSectionStrategy
+{
+public:
+    // Ends to join, with the end node facing back towards the start
+    struct Problem {
+        // Midpoint of end relative to start
+        Vec2f offset;
+        float startDirection, startCurvature;
+        float endDirectionRev, endCurvatureRev;
+        unsigned int numTracks;
+        const TrackSpec *spec;
+        // Previously chosen curve directions, or -1
+        int lastDir1, lastDir2;
+    };
+
+    struct Solution {
+        TrackSectionParams params;
+        // Chosen curve directions, or -1 if there are no curves
+        int dir1, dir2;
+        // Length to choose the shortest by, including any bias towards the
+        // previous choice
+        float length;
+    };
+
+    virtual ~TrackSectionStrategy()
+    {
+    }
+
+    virtual const char *getName() const = 0;
+
+    // Find a shape, returning whether one is valid. Must be safe to call
+    // from multiple threads.
+    virtual bool solve(const Problem &problem, Solution *outSolution) const = 0;
+
+    // Built in strategies, most generally successful first
+    static const std::vector<const TrackSectionStrategy *> &getDefaults();
+    // Cheaper strategies for shapes which will be refined later, such as
+    // while dragging nodes
+    static const std::vector<const TrackSectionStrategy *> &getDrafts();
+};
+
+#endif // TRAINS_TRACK_SECTION_STRATEGY_H
@@ -2,6 +2,7 @@
 #define TRAINS_TRACK_SPEC_H
 
 #include "Gauge.h"
+#include "TransitionTemplate.h"
 
 class TrackSpec
 {
@@ -26,6 +27,9 @@ private:
     // Preferred (minimum) curvature rate (rad/m²)
     float minCurvatureRate;
 
+    // Shared by sections, cleared when the curves change
+    mutable TransitionTemplateCache transitionTemplates;
+
 public:
     // Constructors
 
@@ -46,6 +50,7 @@ public:
     void setTrackSpacing(float newTrackSpacing)
     {
         trackSpacing = newTrackSpacing;
+        transitionTemplates.clear();
     }
 
     void setMaxCurvature(float newMaxCurvature)
@@ -55,6 +60,7 @@ public:
     void setMinCurvature(float newMinCurvature)
     {
         minCurvature = newMinCurvature;
+        transitionTemplates.clear();
     }
 
     void setMaxCurvatureRate(float newMaxCurvatureRate)
@@ -64,6 +70,7 @@ public:
     void setMinCurvatureRate(float newMinCurvatureRate)
     {
         minCurvatureRate = newMinCurvatureRate;
+        transitionTemplates.clear();
     }
 
     // Getters
@@ -91,6 +98,15 @@ public:
     {
         return minCurvature;
     }
+    // Preferred curvature of the middle of multiple tracks, so the track
+    // furthest inside the curve isn't tighter than the minimum radius
+    float getMinCurvature(unsigned int numTracks) const
+    {
+        if (numTracks <= 1)
+            return minCurvature;
+        float displacement = trackSpacing * (numTracks - 1) / 2;
+        return 1.0f / (1.0f / minCurvature + displacement);
+    }
 
     float getMaxCurvatureRate() const
     {
@@ -100,6 +116,12 @@ public:
     {
         return minCurvatureRate;
     }
+
+    // Transitions to and from curves at a node's curvature
+    TransitionTemplate getTransitionTemplate(float curvature, unsigned int numTracks) const
+    {
+        return transitionTemplates.get(*this, curvature, numTracks);
+    }
 };
 
 #endif // TRAINS_TRACK_SPEC_H
@@ -81,3 +81,19 @@ float Train::getLength() const
     len += 1.0f * (units.size() - 1);
     return len;
 }
+
+bool Train::isOnSection(const TrackSection *section) const
+{
+    // The train extends half its length either side of its position
+    float remaining = getLength();
+    TrackPosition pos = position - remaining / 2;
+    while (pos) {
+        if (pos.getSection() == section)
+            return true;
+        float toNext = pos.distanceToSection(true);
+        if (toNext >= remaining || !pos.advanceNextSection(true))
+            return false;
+        remaining -= toNext;
+    }
+    return false;
+}
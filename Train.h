@@ -2,19 +2,25 @@
 #define TRAINS_TRAIN_H
 
 #include "Renderable.h"
+#include "SlotMap.h"
 #include "TrackPosition.h"
 
 #include <list>
 
 class TrackPosition;
+class Train;
 class TrainUnit;
 
+typedef SlotId<Train> TrainId;
+
 // Consists of a number of TrainUnits coupled together into a Train
 class Train : public Renderable
 {
     std::list<TrainUnit *> units;
     TrackPosition position;
     float velocity;
+    // Handle of the train in its railway
+    TrainId id;
 
 public:
     Train();
@@ -29,6 +35,17 @@ public:
     void drive(float dt);
 
     float getLength() const;
+    // Find whether any of the train is on a section
+    bool isOnSection(const TrackSection *section) const;
+
+    void setId(TrainId newId)
+    {
+        id = newId;
+    }
+    TrainId getId() const
+    {
+        return id;
+    }
 
     RENDERABLE_GL();
 };
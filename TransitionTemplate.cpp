@@ -0,0 +1,76 @@
+#include "TransitionTemplate.h"
+#include "TrackSpec.h"
+
+#include <cmath>
+#include <mutex>
+
+// Quantisation step of curvatures
+static constexpr float curvatureStep = 1e-8f;
+
+TransitionTemplate::TransitionTemplate(float curvature, float curvatureRate,
+                                       float minCurvature)
+{
+    for (int d = 0; d < 2; ++d) {
+        float direction = d ? 1.0f : -1.0f;
+        toCurve[d].rate = direction * curvatureRate;
+        toCurve[d].length = (direction * minCurvature - curvature) / toCurve[d].rate;
+        fromCurve[d].rate = -toCurve[d].rate;
+        fromCurve[d].length = minCurvature / curvatureRate;
+
+        ClothoidT transition;
+        transition.setStartCurvature(curvature);
+        transition.setCurvatureRate(toCurve[d].rate);
+        transition.setLength(toCurve[d].length);
+        toCurveDirectionChange[d] = transition.getEndDirectionChange();
+        // exclude direction change to straighten out
+        float distToStraight = transition.lengthAtCurvature(0);
+        if (distToStraight > 0 && distToStraight < toCurve[d].length)
+            toCurveDirectionChange[d] -= transition.directionChangeAtLength(distToStraight);
+        curve[d] = transition.getNextClothoid();
+
+        // Relative to the start of the curve
+        transition = ClothoidT();
+        transition.setStartDirection(curve[d].getStartDirection());
+        transition.setStartCurvature(curve[d].getStartCurvature());
+        transition.setCurvatureRate(fromCurve[d].rate);
+        transition.setLength(fromCurve[d].length);
+        fromCurveDirectionChange[d] = transition.getEndDirectionChange();
+        straight[d] = transition.getNextClothoid();
+
+        transition = ClothoidT();
+        transition.setCurvatureRate(direction * curvatureRate);
+        transition.setLength(fromCurve[d].length);
+        straightToCurveCircle[d] = transition.getNextClothoid().circleAtStart();
+    }
+}
+
+TransitionTemplate TransitionTemplateCache::get(const TrackSpec &spec, float curvature,
+                                                unsigned int numTracks)
+{
+    int32_t quantised = lroundf(curvature / curvatureStep);
+    uint64_t key = (uint64_t)(uint32_t)quantised << 32 | numTracks;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = templates.find(key);
+        if (it != templates.end())
+            return it->second;
+    }
+
+    // Calculate from the quantised curvature so the result doesn't depend
+    // on which section asked first
+    // TODO pick an appropriate rate
+    TransitionTemplate newTemplate(quantised * curvatureStep,
+                                   spec.getMinCurvatureRate(),
+                                   spec.getMinCurvature(numTracks));
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (templates.size() >= maxEntries)
+        templates.clear();
+    templates.emplace(key, newTemplate);
+    return newTemplate;
+}
+
+void TransitionTemplateCache::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    templates.clear();
+}
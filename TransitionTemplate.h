@@ -0,0 +1,62 @@
+#ifndef TRAINS_TRANSITION_TEMPLATE_H
+#define TRAINS_TRANSITION_TEMPLATE_H
+
+#include "Clothoid.h"
+#include "TrackSectionParams.h"
+#include "Vector.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+
+class TrackSpec;
+
+/*
+ * Transition curves between a node's curvature and a track spec's preferred
+ * curves in either direction, with the node at the origin facing east. These
+ * depend only on the curvature, the spec and the number of tracks, so are
+ * shared between all sections rather than recalculated by each.
+ */
+struct TransitionTemplate {
+    typedef Clothoid<float, float> ClothoidT;
+
+    // Indexed by curve direction, 0 for right and 1 for left
+    // Transition from the node's curvature to the curve
+    TransitionParams toCurve[2];
+    // Transition from the curve to straight
+    TransitionParams fromCurve[2];
+    // Clothoid starting at the curve
+    ClothoidT curve[2];
+    // Clothoid starting at the straight after it, relative to the curve
+    ClothoidT straight[2];
+    // Direction changes of the transitions, the first excluding any part
+    // spent straightening out from the node's curvature
+    float toCurveDirectionChange[2];
+    float fromCurveDirectionChange[2];
+    // Centre of the curve reached by a transition from a straight at the
+    // origin facing east
+    Vec2f straightToCurveCircle[2];
+
+    TransitionTemplate(float curvature, float curvatureRate, float minCurvature);
+};
+
+// Templates of a track spec by quantised curvature and number of tracks
+class TransitionTemplateCache
+{
+private:
+    // Entries are discarded wholesale beyond this many. Nodes dragged
+    // through continuous curvatures would otherwise each leave one behind.
+    static constexpr size_t maxEntries = 1 << 12;
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<uint64_t, TransitionTemplate> templates;
+
+public:
+    // Returns a copy, as the cached template may be discarded at any time
+    TransitionTemplate get(const TrackSpec &spec, float curvature,
+                           unsigned int numTracks);
+    void clear();
+};
+
+#endif // TRAINS_TRANSITION_TEMPLATE_H
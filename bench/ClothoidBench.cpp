@@ -0,0 +1,168 @@
+/*
+ * Clothoid sampling benchmark.
+ *
+ * Compares Clothoid::sampleUniform() against evaluating each sample with
+ * positionAtLength() and the direction with sincos, as rendering used to.
+ * Errors are measured against a double precision clothoid, returning
+ * failure if sampleUniform() is significantly less accurate.
+ * Also checks parallel lengths and positions against the lengths of finely
+ * sampled parallel lines.
+ */
+
+#include "Vector.h"
+#include "Clothoid.h"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+    typedef Clothoid<float, float> ClothoidF;
+    typedef Clothoid<double, double> ClothoidD;
+
+    template <typename F>
+    double timePerItem(unsigned int items, F func)
+    {
+        constexpr unsigned int repeats = 20;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < repeats; ++i)
+            func();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count()
+             / (repeats * items);
+    }
+
+    struct Shape {
+        const char *name;
+        float startCurvature;
+        float curvatureRate;
+        float length;
+    };
+
+    bool measureSampling()
+    {
+        bool ok = true;
+        const Shape shapes[] = {
+            { "straight", 0, 0, 2000 },
+            { "curve", 1.0f / 30, 0, 2000 },
+            { "transition", 0, 1.0f / 300, 10 },
+            { "transition", -1.0f / 30, 1.0f / 3000, 200 },
+            { "long transition", 1.0f / 30, -1.0f / 30000, 2000 },
+        };
+        const float steps[] = { 0.65f, 1.0f, 4.0f };
+
+        std::cout << "sampleUniform: max position error (m), max direction error, ns/sample"
+                  << std::endl;
+        for (const Shape &shape: shapes) {
+            ClothoidF clothoid;
+            clothoid.setStartPosition(Vec2f(1000, -2000));
+            clothoid.setStartDirection(0.3f);
+            clothoid.setStartCurvature(shape.startCurvature);
+            clothoid.setCurvatureRate(shape.curvatureRate);
+            clothoid.setLength(shape.length);
+            ClothoidD reference;
+            reference.setStartPosition(maths::Vector<2, double>(1000, -2000));
+            reference.setStartDirection(0.3f);
+            reference.setStartCurvature(shape.startCurvature);
+            reference.setCurvatureRate(shape.curvatureRate);
+            reference.setLength(shape.length);
+
+            for (float step: steps) {
+                unsigned int count = (unsigned int)(shape.length / step) + 1;
+                std::vector<Vec2f> positions(count), directions(count);
+                std::vector<Vec2f> scalarPositions(count), scalarDirections(count);
+
+                double scalarNs = timePerItem(count, [&]() {
+                    for (unsigned int i = 0; i < count; ++i) {
+                        float len = step * i;
+                        scalarPositions[i] = clothoid.positionAtLength(len);
+                        sincosf(clothoid.directionAtLength(len),
+                                &scalarDirections[i][1], &scalarDirections[i][0]);
+                    }
+                });
+                double sampleNs = timePerItem(count, [&]() {
+                    clothoid.sampleUniform(0, step, count,
+                                           positions.data(), directions.data());
+                });
+
+                double maxScalarError = 0, maxScalarDirError = 0;
+                double maxError = 0, maxDirError = 0;
+                for (unsigned int i = 0; i < count; ++i) {
+                    maths::Vector<2, double> ref = reference.positionAtLength((double)step * i);
+                    double refDir = reference.directionAtLength((double)step * i);
+                    maths::Vector<2, double> refDirVec(cos(refDir), sin(refDir));
+                    maxScalarError = std::max(maxScalarError,
+                            (ref - (maths::Vector<2, double>)scalarPositions[i]).mag());
+                    maxError = std::max(maxError,
+                            (ref - (maths::Vector<2, double>)positions[i]).mag());
+                    maxScalarDirError = std::max(maxScalarDirError,
+                            (refDirVec - (maths::Vector<2, double>)scalarDirections[i]).mag());
+                    maxDirError = std::max(maxDirError,
+                            (refDirVec - (maths::Vector<2, double>)directions[i]).mag());
+                }
+
+                std::cout << std::setw(16) << shape.name << " step " << std::setw(4)
+                          << step << ": " << std::setprecision(3)
+                          << std::setw(9) << maxError << " " << std::setw(9) << maxDirError
+                          << " " << std::setw(6) << sampleNs << "ns"
+                          << "  (positionAtLength " << std::setw(9) << maxScalarError
+                          << " " << std::setw(9) << maxScalarDirError
+                          << " " << std::setw(6) << scalarNs << "ns)" << std::endl;
+                ok = ok && maxError < 2 * maxScalarError + 1e-4
+                        && maxDirError < 2 * maxScalarDirError + 1e-5;
+            }
+        }
+        return ok;
+    }
+
+    // Compare parallel lengths with the sum of many short chords
+    bool measureParallel()
+    {
+        const double offsets[] = { -6, -2.5, 2.5, 6 };
+        const Shape shapes[] = {
+            { "curve", 1.0f / 30, 0, 60 },
+            { "transition", 0, 1.0f / 3000, 60 },
+            { "transition", 1.0f / 30, -1.0f / 1000, 60 },
+        };
+        constexpr unsigned int chords = 100000;
+
+        double maxLengthError = 0, maxPositionError = 0;
+        for (const Shape &shape: shapes) {
+            ClothoidD clothoid;
+            clothoid.setStartDirection(0.2);
+            clothoid.setStartCurvature(shape.startCurvature);
+            clothoid.setCurvatureRate(shape.curvatureRate);
+            clothoid.setLength(shape.length);
+            for (double offset: offsets) {
+                double parallelLength = 0;
+                maths::Vector<2, double> last = clothoid.parallelPositionAtLength(offset, 0);
+                for (unsigned int i = 1; i <= chords; ++i) {
+                    double len = (double)shape.length * i / chords;
+                    maths::Vector<2, double> pos = clothoid.parallelPositionAtLength(offset, len);
+                    parallelLength += (pos - last).mag();
+                    last = pos;
+                    if (i % 1000 == 0) {
+                        maths::Vector<2, double> found =
+                            clothoid.parallelPositionAtParallelLength(offset, parallelLength);
+                        maxPositionError = std::max(maxPositionError, (found - pos).mag());
+                    }
+                }
+                maxLengthError = std::max(maxLengthError,
+                        fabs(parallelLength - clothoid.getParallelLength(offset)));
+            }
+        }
+        std::cout << "parallel lines: max length error " << std::setprecision(3)
+                  << maxLengthError << "m, max position error "
+                  << maxPositionError << "m" << std::endl;
+        return maxLengthError < 1e-6 && maxPositionError < 1e-6;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool ok = measureSampling();
+    ok = measureParallel() && ok;
+    return ok ? 0 : 1;
+}
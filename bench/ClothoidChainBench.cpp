@@ -0,0 +1,158 @@
+/*
+ * Clothoid chain lookup benchmark.
+ *
+ * Simulates wheelsets advancing a few centimetres per tick along clothoid
+ * chains, comparing position lookups by binary search with lookups through
+ * a ClothoidChain::Cursor carried by each wheelset. Returns failure if the
+ * results differ.
+ * Also measures projection of points onto a chain, checking against the
+ * closest of densely sampled points.
+ */
+
+#include "Vector.h"
+#include "ClothoidChain.h"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+    typedef ClothoidChain<float, float> ChainF;
+
+    constexpr unsigned int numWheelsets = 10000;
+    constexpr unsigned int numTicks = 200;
+
+    // Build a chain alternating transitions, curves and straights
+    void buildChain(ChainF *chain, unsigned int numClothoids)
+    {
+        std::mt19937 rng(4);
+        std::uniform_real_distribution<float> lengths(20, 200);
+        float curvature = 0;
+        ChainF::Clothoid *clothoid = chain->append();
+        clothoid->setStartPosition(Vec2f(-500, 300));
+        for (unsigned int i = 0; i < numClothoids; ++i) {
+            float length = lengths(rng);
+            if (i % 2 == 0) {
+                // Transition to or from a curve
+                float target = curvature ? 0 : ((i % 4) ? 1.0f : -1.0f) / 500;
+                clothoid->setCurvatureRate((target - curvature) / length);
+                curvature = target;
+            }
+            clothoid->setLength(length);
+            clothoid = chain->append();
+        }
+    }
+
+    struct Wheelset {
+        float distance;
+        float speed;
+        ChainF::Cursor cursor;
+    };
+
+    bool measure(const char *name, unsigned int numClothoids)
+    {
+        ChainF chain;
+        buildChain(&chain, numClothoids);
+        const float leftOffset = -2.5f;
+        const float length = chain.parallelLength(leftOffset);
+
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> distances(0, length);
+        std::uniform_real_distribution<float> speeds(-0.1f, 0.1f);
+        std::vector<Wheelset> wheelsets(numWheelsets);
+        for (Wheelset &wheelset: wheelsets) {
+            wheelset.distance = distances(rng);
+            wheelset.speed = speeds(rng);
+        }
+        std::vector<Vec2f> searched(numWheelsets), cursored(numWheelsets);
+
+        double searchNs = 0, cursorNs = 0;
+        bool ok = true;
+        for (unsigned int tick = 0; tick < numTicks; ++tick) {
+            for (Wheelset &wheelset: wheelsets) {
+                wheelset.distance += wheelset.speed;
+                if (wheelset.distance < 0 || wheelset.distance > length)
+                    wheelset.speed = -wheelset.speed;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned int i = 0; i < numWheelsets; ++i)
+                searched[i] = chain.parallelPositionAtParallelLength(leftOffset,
+                                                                     wheelsets[i].distance);
+            auto mid = std::chrono::steady_clock::now();
+            for (unsigned int i = 0; i < numWheelsets; ++i)
+                cursored[i] = chain.parallelPositionAtParallelLength(&wheelsets[i].cursor,
+                                                                     leftOffset,
+                                                                     wheelsets[i].distance);
+            auto end = std::chrono::steady_clock::now();
+            searchNs += std::chrono::duration<double, std::nano>(mid - start).count();
+            cursorNs += std::chrono::duration<double, std::nano>(end - mid).count();
+
+            for (unsigned int i = 0; i < numWheelsets; ++i)
+                ok = ok && searched[i] == cursored[i];
+        }
+
+        const unsigned int queries = numWheelsets * numTicks;
+        std::cout << std::setw(20) << name << ": search " << std::setprecision(3)
+                  << std::setw(6) << searchNs / queries << "ns, cursor "
+                  << std::setw(6) << cursorNs / queries << "ns per query"
+                  << (ok ? "" : " MISMATCH") << std::endl;
+        return ok;
+    }
+
+    bool measureProjection()
+    {
+        ChainF chain;
+        buildChain(&chain, 8);
+        const float length = chain.length();
+
+        // Points scattered around the chain
+        constexpr unsigned int numPoints = 1000;
+        std::mt19937 rng(6);
+        std::uniform_real_distribution<float> lengths(0, length);
+        std::uniform_real_distribution<float> offsets(-20, 20);
+        std::vector<Vec2f> points(numPoints);
+        for (Vec2f &point: points)
+            point = chain.parallelPositionAtParallelLength(offsets(rng), lengths(rng));
+
+        std::vector<ChainF::Projection> projections(numPoints);
+        constexpr unsigned int repeats = 20;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int r = 0; r < repeats; ++r)
+            for (unsigned int i = 0; i < numPoints; ++i)
+                chain.project(points[i], &projections[i]);
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count()
+                  / (repeats * numPoints);
+
+        // Brute force every centimetre
+        float maxExcess = 0, maxOffsetError = 0;
+        for (unsigned int i = 0; i < numPoints; ++i) {
+            float bestDistance = std::numeric_limits<float>::max();
+            for (float len = 0; len <= length; len += 0.01f)
+                bestDistance = std::min(bestDistance,
+                                        (chain.positionAtLength(len) - points[i]).mag());
+            const ChainF::Projection &projection = projections[i];
+            maxExcess = std::max(maxExcess, projection.distance - bestDistance);
+            maxOffsetError = std::max(maxOffsetError,
+                    std::fabs(std::fabs(projection.leftOffset) - projection.distance));
+        }
+        std::cout << "project: " << std::setprecision(3) << ns << "ns per query ("
+                  << 1e3 / ns << "M/s), max excess distance " << maxExcess
+                  << "m, max offset error " << maxOffsetError << "m" << std::endl;
+        return maxExcess < 1e-3f && maxOffsetError < 1e-3f;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::cout << numWheelsets << " wheelsets, " << numTicks << " ticks" << std::endl;
+    bool ok = measure("section (8 clothoids)", 8);
+    ok = measure("route (1000 clothoids)", 1000) && ok;
+    ok = measureProjection() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+/*
+ * Clothoid packet benchmark.
+ *
+ * Compares evaluating end positions, end directions and turning circles of
+ * many clothoids with ClothoidPacket against the same calls on scalar
+ * Clothoids, as the track section candidate sweep used to. Returns failure
+ * if the packet results differ from the scalar ones by more than rounding.
+ */
+
+#include "Vector.h"
+#include "Clothoid.h"
+#include "ClothoidPacket.h"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+    typedef Clothoid<float, float> ClothoidF;
+
+    template <typename F>
+    double timePerItem(unsigned int items, F func)
+    {
+        constexpr unsigned int repeats = 20;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < repeats; ++i)
+            func();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count()
+             / (repeats * items);
+    }
+
+    // Random clothoids like those of track sections, including curves and
+    // straights
+    std::vector<ClothoidF> makeClothoids(unsigned int count)
+    {
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> positions(-5000, 5000);
+        std::uniform_real_distribution<float> directions(-M_PI, M_PI);
+        std::uniform_real_distribution<float> curvatures(-1.0f / 30, 1.0f / 30);
+        std::uniform_real_distribution<float> rates(-1.0f / 300, 1.0f / 300);
+        std::uniform_real_distribution<float> lengths(0, 150);
+        std::vector<ClothoidF> clothoids(count);
+        for (unsigned int i = 0; i < count; ++i) {
+            ClothoidF &clothoid = clothoids[i];
+            clothoid.setStartPosition(Vec2f(positions(rng), positions(rng)));
+            clothoid.setStartDirection(directions(rng));
+            clothoid.setStartCurvature(i % 8 == 7 ? 0 : curvatures(rng));
+            clothoid.setCurvatureRate(i % 4 == 3 ? 0 : rates(rng));
+            clothoid.setLength(lengths(rng));
+        }
+        return clothoids;
+    }
+
+    struct Results {
+        std::vector<Vec2f> positions;
+        std::vector<float> directions;
+        std::vector<Vec2f> circles;
+
+        explicit Results(unsigned int count)
+        : positions(count), directions(count), circles(count)
+        {
+        }
+    };
+
+    template <unsigned int N>
+    bool measure(const std::vector<ClothoidF> &clothoids, const Results &scalar,
+                 double scalarNs)
+    {
+        const unsigned int count = clothoids.size() / N * N;
+        std::vector<ClothoidPacket<N>> packets(count / N);
+        for (unsigned int i = 0; i < count; ++i)
+            packets[i / N].set(i % N, clothoids[i]);
+
+        Results results(count);
+        double packetNs = timePerItem(count, [&]() {
+            for (unsigned int p = 0; p < packets.size(); ++p) {
+                packets[p].getEndPositions(&results.positions[p * N]);
+                packets[p].getEndDirections(&results.directions[p * N]);
+                packets[p].circlesAtStart(&results.circles[p * N]);
+            }
+        });
+
+        double maxPositionError = 0, maxDirectionError = 0;
+        for (unsigned int i = 0; i < count; ++i) {
+            // Relative to the magnitude for positions, which may be large
+            float scale = std::max(1.0f, scalar.positions[i].mag());
+            maxPositionError = std::max(maxPositionError,
+                    (double)(results.positions[i] - scalar.positions[i]).mag() / scale);
+            maxDirectionError = std::max(maxDirectionError,
+                    (double)fabs(results.directions[i] - scalar.directions[i]));
+            if (std::isfinite(scalar.circles[i][0])) {
+                float circleScale = std::max(1.0f, scalar.circles[i].mag());
+                maxPositionError = std::max(maxPositionError,
+                        (double)(results.circles[i] - scalar.circles[i]).mag() / circleScale);
+            }
+        }
+
+        std::cout << "ClothoidPacket<" << N << ">: " << std::setprecision(3)
+                  << std::setw(6) << packetNs << "ns per clothoid, speedup "
+                  << std::setw(4) << scalarNs / packetNs
+                  << ", max relative position error " << maxPositionError
+                  << ", max direction error " << maxDirectionError << std::endl;
+        return maxPositionError < 1e-5 && maxDirectionError < 1e-5;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned int count = 1 << 14;
+    std::vector<ClothoidF> clothoids = makeClothoids(count);
+
+    Results scalar(count);
+    double scalarNs = timePerItem(count, [&]() {
+        for (unsigned int i = 0; i < count; ++i) {
+            scalar.positions[i] = clothoids[i].getEndPosition();
+            scalar.directions[i] = clothoids[i].getEndDirection();
+            scalar.circles[i] = clothoids[i].circleAtStart();
+        }
+    });
+    std::cout << "Clothoid:          " << std::setprecision(3) << std::setw(6)
+              << scalarNs << "ns per clothoid" << std::endl;
+
+    bool ok = measure<2>(clothoids, scalar, scalarNs);
+    ok = measure<4>(clothoids, scalar, scalarNs) && ok;
+    ok = measure<8>(clothoids, scalar, scalarNs) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+/*
+ * Fresnel integral accuracy and speed benchmark.
+ *
+ * Compares fresnel(), fresnelTable() and the old truncated power series against a reference
+ * calculated by composite Gauss-Legendre quadrature in long double precision.
+ * Also checks fresnelBatch() and Clothoid::positionsAtLengths() against the
+ * scalar versions, returning failure if they differ significantly.
+ */
+
+#include "Vector.h"
+#include "Clothoid.h"
+#include "Fresnel.h"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+    // Gauss-Legendre quadrature nodes and weights on [-1, 1]
+    constexpr unsigned int quadratureOrder = 10;
+    long double nodes[quadratureOrder];
+    long double weights[quadratureOrder];
+
+    void initQuadrature()
+    {
+        const unsigned int n = quadratureOrder;
+        for (unsigned int i = 0; i < n; ++i) {
+            long double x = cosl(M_PI * (i + 0.75L) / (n + 0.5L));
+            long double dp;
+            for (int it = 0; it < 100; ++it) {
+                // Legendre polynomial P_n(x) and derivative by recurrence
+                long double p0 = 1, p1 = x;
+                for (unsigned int k = 2; k <= n; ++k) {
+                    long double p2 = ((2*k - 1) * x * p1 - (k - 1) * p0) / k;
+                    p0 = p1;
+                    p1 = p2;
+                }
+                dp = n * (x * p1 - p0) / (x * x - 1);
+                long double dx = p1 / dp;
+                x -= dx;
+                if (fabsl(dx) < 1e-19L)
+                    break;
+            }
+            nodes[i] = x;
+            weights[i] = 2 / ((1 - x * x) * dp * dp);
+        }
+    }
+
+    // Integrate (cos(t²), sin(t²)) from a to b
+    void integrate(long double a, long double b, long double *c, long double *s)
+    {
+        long double mid = (a + b) / 2;
+        long double half = (b - a) / 2;
+        *c = *s = 0;
+        for (unsigned int i = 0; i < quadratureOrder; ++i) {
+            long double t = mid + half * nodes[i];
+            *c += weights[i] * cosl(t * t);
+            *s += weights[i] * sinl(t * t);
+        }
+        *c *= half;
+        *s *= half;
+    }
+
+    // Reference values from cumulative integration over short panels
+    class Reference
+    {
+    private:
+        long double step;
+        std::vector<long double> c, s;
+
+    public:
+        Reference(long double maxX, unsigned int panelsPerUnit)
+        : step(1.0L / panelsPerUnit)
+        {
+            unsigned int panels = (unsigned int)ceill(maxX * panelsPerUnit);
+            c.resize(panels + 1);
+            s.resize(panels + 1);
+            c[0] = s[0] = 0;
+            for (unsigned int i = 0; i < panels; ++i) {
+                long double pc, ps;
+                integrate(step * i, step * (i + 1), &pc, &ps);
+                c[i + 1] = c[i] + pc;
+                s[i + 1] = s[i] + ps;
+            }
+        }
+
+        void calc(long double x, long double *outC, long double *outS) const
+        {
+            long double xMag = fabsl(x);
+            unsigned int i = (unsigned int)(xMag / step);
+            long double pc, ps;
+            integrate(step * i, xMag, &pc, &ps);
+            *outC = c[i] + pc;
+            *outS = s[i] + ps;
+            if (x < 0) {
+                *outC = -*outC;
+                *outS = -*outS;
+            }
+        }
+    };
+
+    template <typename T>
+    struct Method {
+        const char *name;
+        maths::Vector<2, T> (*calc)(T);
+    };
+
+    template <typename T>
+    void measure(const char *typeName, const Reference &reference)
+    {
+        const Method<T> methods[] = {
+            { "fresnel", &fresnel<T> },
+            { "fresnelTable", &fresnelTable<T> },
+            { "powerSeries", &Fresnel::powerSeries<T> },
+        };
+        // Error is reported separately for each approximation range
+        const T ranges[] = { 0, 2, 4, 8, 32 };
+        constexpr unsigned int numRanges = sizeof(ranges) / sizeof(ranges[0]) - 1;
+        constexpr unsigned int samplesPerRange = 20000;
+
+        std::mt19937 rng(1);
+        std::vector<T> args[numRanges];
+        for (unsigned int r = 0; r < numRanges; ++r) {
+            std::uniform_real_distribution<T> dist(ranges[r], ranges[r + 1]);
+            args[r].resize(samplesPerRange);
+            for (T &x: args[r])
+                x = dist(rng);
+        }
+
+        for (const Method<T> &method: methods) {
+            std::cout << typeName << " " << std::setw(12) << std::left
+                      << method.name << std::right;
+            for (unsigned int r = 0; r < numRanges; ++r) {
+                // Maximum absolute error
+                long double maxError = 0;
+                for (T x: args[r]) {
+                    long double refC, refS;
+                    reference.calc(x, &refC, &refS);
+                    maths::Vector<2, T> val = method.calc(x);
+                    maxError = std::max(maxError, fabsl(val[0] - refC));
+                    maxError = std::max(maxError, fabsl(val[1] - refS));
+                }
+
+                // Time per call
+                constexpr unsigned int repeats = 50;
+                T sink = 0;
+                auto start = std::chrono::steady_clock::now();
+                for (unsigned int i = 0; i < repeats; ++i)
+                    for (T x: args[r])
+                        sink += method.calc(x)[0];
+                auto end = std::chrono::steady_clock::now();
+                double ns = std::chrono::duration<double, std::nano>(end - start).count()
+                          / (repeats * samplesPerRange);
+                volatile T keep = sink;
+                (void)keep;
+
+                std::cout << "  [" << ranges[r] << "," << ranges[r + 1] << "): "
+                          << std::setprecision(3) << std::setw(9)
+                          << (double)maxError << " " << std::setw(6) << ns << "ns";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    template <typename F>
+    double timePerItem(unsigned int items, F func)
+    {
+        constexpr unsigned int repeats = 50;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < repeats; ++i)
+            func();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count()
+             / (repeats * items);
+    }
+
+    // Compare batch and scalar evaluation, returning false on mismatch
+    bool measureBatch()
+    {
+        constexpr unsigned int n = 100000;
+        std::mt19937 rng(2);
+        std::uniform_real_distribution<float> dist(-64, 64);
+        std::vector<float> args(n);
+        for (float &x: args)
+            x = dist(rng);
+
+        std::vector<Vec2f> scalar(n), batch(n);
+        double scalarNs = timePerItem(n, [&]() {
+            for (unsigned int i = 0; i < n; ++i)
+                scalar[i] = fresnel(args[i]);
+        });
+        double batchNs = timePerItem(n, [&]() {
+            fresnelBatch(args.data(), batch.data(), n);
+        });
+        float maxDiff = 0;
+        for (unsigned int i = 0; i < n; ++i)
+            maxDiff = std::max(maxDiff, (batch[i] - scalar[i]).mag());
+        std::cout << "fresnelBatch: max difference " << std::setprecision(3)
+                  << maxDiff << ", " << batchNs << "ns vs " << scalarNs
+                  << "ns scalar" << std::endl;
+        bool ok = maxDiff < 1e-6f;
+
+        // A long transition curve
+        Clothoid<float, float> clothoid;
+        clothoid.setStartPosition(Vec2f(100, -50));
+        clothoid.setStartDirection(1.0f);
+        clothoid.setStartCurvature(1.0f / 30);
+        clothoid.setCurvatureRate(-1.0f / 300);
+        clothoid.setLength(500);
+        std::vector<float> lengths(n);
+        for (unsigned int i = 0; i < n; ++i)
+            lengths[i] = clothoid.getLength() * i / n;
+        scalarNs = timePerItem(n, [&]() {
+            for (unsigned int i = 0; i < n; ++i)
+                scalar[i] = clothoid.positionAtLength(lengths[i]);
+        });
+        batchNs = timePerItem(n, [&]() {
+            clothoid.positionsAtLengths(lengths.data(), batch.data(), n);
+        });
+        maxDiff = 0;
+        for (unsigned int i = 0; i < n; ++i)
+            maxDiff = std::max(maxDiff, (batch[i] - scalar[i]).mag());
+        std::cout << "positionsAtLengths: max difference " << maxDiff << "m, "
+                  << batchNs << "ns vs " << scalarNs << "ns scalar" << std::endl;
+        ok = ok && maxDiff < 1e-3f;
+
+        return ok;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    initQuadrature();
+    Reference reference(32, 64);
+
+    std::cout << "max absolute error and time per call by range of |x|" << std::endl;
+    measure<float>("float ", reference);
+    measure<double>("double", reference);
+
+    return measureBatch() ? 0 : 1;
+}
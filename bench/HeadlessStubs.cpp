@@ -0,0 +1,35 @@
+/*
+ * Empty OpenGL rendering for tools which use the railway model without a
+ * window, so they don't need to link the *GL.cpp files or OpenGL.
+ */
+
+#include "Railway.h"
+#include "TrackSection.h"
+#include "Train.h"
+#include "TrainBogie.h"
+#include "TrainUnit.h"
+#include "TrainWheelset.h"
+
+void Railway::renderGL(RendererOpenGL *renderer)
+{
+}
+
+void TrackSection::renderGL(RendererOpenGL *renderer)
+{
+}
+
+void Train::renderGL(RendererOpenGL *renderer)
+{
+}
+
+void TrainUnit::renderGL(RendererOpenGL *renderer)
+{
+}
+
+void TrainBogie::renderGL(RendererOpenGL *renderer)
+{
+}
+
+void TrainWheelset::renderGL(RendererOpenGL *renderer)
+{
+}
@@ -0,0 +1,296 @@
+/*
+ * Headless track section interpolation benchmark.
+ *
+ * Generates a reproducible corpus of random node pairs, varying the
+ * distance and bearing between them, their directions and curvatures, the
+ * number of tracks and the track spec, and interpolates a section between
+ * each pair without a railway (so without caching or threads). Reports
+ * sections per second, how many sections reach their end node, the
+ * distribution of section lengths relative to the straight line distance,
+ * how far the tracks end from the end node, and the clothoid pair
+ * solver's outcomes and iterations, as JSON.
+ *
+ * Usage: interpolationbench [count [seed]] [--corpus]
+ * With --corpus the node pairs are written as CSV instead.
+ * Returns failure if any section length is not finite.
+ */
+
+#include "Gauge.h"
+#include "TrackNode.h"
+#include "TrackSection.h"
+#include "TrackSpec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+    // A pair of nodes to join, with the end relative to the start
+    struct Config {
+        Vec2f start;
+        float startDirection, startCurvature;
+        float distance, bearing;
+        float endDirection, endCurvature;
+        unsigned int numTracks;
+        unsigned int spec;
+    };
+
+    struct Spec {
+        const char *name;
+        float trackSpacing;
+        float minRadius, maxRadius;
+        // Length over which a transition reaches the radius
+        float transitionLength;
+    };
+    const Spec specs[] = {
+        { "tight", 3.0f, 30, 20, 10 },
+        { "branch", 3.5f, 150, 100, 40 },
+        { "main", 4.0f, 600, 300, 100 },
+    };
+    constexpr unsigned int numSpecs = sizeof(specs) / sizeof(specs[0]);
+    constexpr unsigned int maxTracks = 4;
+
+    std::vector<Config> generate(unsigned int count, unsigned int seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> unit(0, 1);
+        std::uniform_real_distribution<float> positions(-5000, 5000);
+        std::uniform_real_distribution<float> angles(-M_PI, M_PI);
+        std::uniform_int_distribution<unsigned int> tracks(1, maxTracks);
+        std::uniform_int_distribution<unsigned int> specIndices(0, numSpecs - 1);
+
+        std::vector<Config> corpus(count);
+        for (Config &config: corpus) {
+            config.spec = specIndices(rng);
+            const Spec &spec = specs[config.spec];
+            // Node curvatures are limited like TrackMode's, and are often 0
+            auto curvature = [&]() {
+                if (unit(rng) < 0.4f)
+                    return 0.0f;
+                return (unit(rng) * 2 - 1) * 0.9f / spec.maxRadius;
+            };
+            config.start = Vec2f(positions(rng), positions(rng));
+            config.startDirection = angles(rng);
+            config.startCurvature = curvature();
+            // Log uniform from 5m to 2km
+            config.distance = 5 * powf(400, unit(rng));
+            // Mostly ahead, sometimes anywhere
+            config.bearing = unit(rng) < 0.8f ? angles(rng) / 4 : angles(rng);
+            config.endDirection = config.startDirection + angles(rng);
+            config.endCurvature = curvature();
+            config.numTracks = tracks(rng);
+        }
+        return corpus;
+    }
+
+    void writeCorpus(const std::vector<Config> &corpus)
+    {
+        std::cout << "x,y,direction,curvature,distance,bearing,endDirection,"
+                     "endCurvature,numTracks,spec" << std::endl;
+        std::cout.precision(9);
+        for (const Config &config: corpus) {
+            std::cout << config.start[0] << ',' << config.start[1] << ','
+                      << config.startDirection << ',' << config.startCurvature << ','
+                      << config.distance << ',' << config.bearing << ','
+                      << config.endDirection << ',' << config.endCurvature << ','
+                      << config.numTracks << ',' << specs[config.spec].name << std::endl;
+        }
+    }
+
+    // Value at fraction of sorted values
+    float percentile(const std::vector<float> &sorted, float fraction)
+    {
+        if (sorted.empty())
+            return 0;
+        size_t i = std::min(sorted.size() - 1, (size_t)(fraction * sorted.size()));
+        return sorted[i];
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int count = 20000;
+    unsigned int seed = 1;
+    bool corpusOnly = false;
+    unsigned int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--corpus"))
+            corpusOnly = true;
+        else if (positional++ == 0)
+            count = atoi(argv[i]);
+        else
+            seed = atoi(argv[i]);
+    }
+
+    std::vector<Config> corpus = generate(count, seed);
+    if (corpusOnly) {
+        writeCorpus(corpus);
+        return 0;
+    }
+
+    Gauge gauge;
+    gauge.addRail(nullptr, Vec2f(-0.7175f, 0));
+    gauge.addRail(nullptr, Vec2f(0.7175f, 0));
+    TrackSpec trackSpecs[numSpecs];
+    for (unsigned int i = 0; i < numSpecs; ++i) {
+        TrackSpec &trackSpec = trackSpecs[i];
+        trackSpec.setName(specs[i].name);
+        trackSpec.setTrackGauge(&gauge);
+        trackSpec.setTrackSpacing(specs[i].trackSpacing);
+        trackSpec.setMaxCurvature(1.0f / specs[i].maxRadius);
+        trackSpec.setMinCurvature(1.0f / specs[i].minRadius);
+        trackSpec.setMaxCurvatureRate(trackSpec.getMaxCurvature() / specs[i].transitionLength);
+        trackSpec.setMinCurvatureRate(trackSpec.getMinCurvature() / specs[i].transitionLength);
+    }
+
+    // Sections are interpolated as they are created
+    TrackSection::resetClothoidPairStats();
+    std::vector<TrackNode *> nodes;
+    std::vector<TrackSection *> sections;
+    nodes.reserve(count * 2);
+    sections.reserve(count);
+    for (const Config &config: corpus) {
+        const TrackSpec *spec = &trackSpecs[config.spec];
+        TrackNode *start = new TrackNode(spec);
+        start->setNumTracks(config.numTracks);
+        start->setMidpoint((Vec3f)config.start);
+        start->setDirection(config.startDirection);
+        start->setCurvature(config.startCurvature);
+        TrackNode *end = new TrackNode(spec);
+        end->setNumTracks(config.numTracks);
+        float bearing = config.startDirection + config.bearing;
+        end->setMidpoint((Vec3f)(config.start + Vec2f(cosf(bearing), sinf(bearing)) * config.distance));
+        end->setDirection(config.endDirection);
+        end->setCurvature(config.endCurvature);
+        nodes.push_back(start);
+        nodes.push_back(end);
+        sections.push_back(new TrackSection(start->forward(), end->backward(), spec));
+    }
+    TrackSection::ClothoidPairStats pairStats = TrackSection::getClothoidPairStats();
+
+    // Quality, by whether each track reaches the end node
+    constexpr float positionTolerance = 0.01f;
+    unsigned int succeeded = 0, noShape = 0, missedEnd = 0;
+    unsigned int succeededByTracks[maxTracks + 1] = {}, countByTracks[maxTracks + 1] = {};
+    unsigned int succeededBySpec[numSpecs] = {}, countBySpec[numSpecs] = {};
+    bool finite = true;
+    std::vector<float> ratios, endErrors;
+    ratios.reserve(count);
+    endErrors.reserve(count);
+    for (unsigned int i = 0; i < count; ++i) {
+        const TrackSection *section = sections[i];
+        const Config &config = corpus[i];
+        ++countByTracks[config.numTracks];
+        ++countBySpec[config.spec];
+        float length = section->getLength(0);
+        if (!std::isfinite(length)) {
+            finite = false;
+            ++missedEnd;
+            continue;
+        }
+        if (length <= 0) {
+            ++noShape;
+            continue;
+        }
+        float endError = 0;
+        for (unsigned int t = 0; t < config.numTracks; ++t) {
+            Vec2f endPosition = (Vec2f)section->getPosition(t, section->getLength(t));
+            Vec2f expected = (Vec2f)section->end().getPosition(config.numTracks - 1 - t);
+            endError = std::max(endError, (endPosition - expected).mag());
+        }
+        endErrors.push_back(endError);
+        if (endError >= positionTolerance) {
+            ++missedEnd;
+            continue;
+        }
+        ++succeeded;
+        ++succeededByTracks[config.numTracks];
+        ++succeededBySpec[config.spec];
+        float straight = ((Vec2f)section->end().getMidpoint() - (Vec2f)section->start().getMidpoint()).mag();
+        ratios.push_back(section->getLength(0) / straight);
+    }
+    std::sort(ratios.begin(), ratios.end());
+    std::sort(endErrors.begin(), endErrors.end());
+    const float ratioBuckets[] = { 1.01f, 1.05f, 1.1f, 1.25f, 1.5f, 2, 3, 5, INFINITY };
+    constexpr unsigned int numRatioBuckets = sizeof(ratioBuckets) / sizeof(ratioBuckets[0]);
+    unsigned int ratioCounts[numRatioBuckets] = {};
+    for (float ratio: ratios) {
+        unsigned int b = 0;
+        while (ratio >= ratioBuckets[b])
+            ++b;
+        ++ratioCounts[b];
+    }
+
+    // Speed, once the transition templates are warm
+    constexpr unsigned int repeats = 3;
+    auto startTime = std::chrono::steady_clock::now();
+    for (unsigned int r = 0; r < repeats; ++r) {
+        for (TrackSection *section: sections)
+            section->interpolate();
+    }
+    auto endTime = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(endTime - startTime).count() / repeats;
+
+    // JSON
+    std::cout.precision(6);
+    std::cout << "{\n"
+              << "  \"seed\": " << seed << ",\n"
+              << "  \"sections\": " << count << ",\n"
+              << "  \"sectionsPerSecond\": " << count / seconds << ",\n"
+              << "  \"nsPerSection\": " << seconds * 1e9 / count << ",\n"
+              << "  \"succeeded\": " << succeeded << ",\n"
+              << "  \"successRate\": " << (double)succeeded / count << ",\n"
+              << "  \"failures\": { \"noShape\": " << noShape
+              << ", \"missedEnd\": " << missedEnd << " },\n";
+    std::cout << "  \"successRateByTracks\": {";
+    for (unsigned int t = 1; t <= maxTracks; ++t) {
+        std::cout << (t > 1 ? ", " : " ") << '"' << t << "\": "
+                  << (countByTracks[t] ? (double)succeededByTracks[t] / countByTracks[t] : 0);
+    }
+    std::cout << " },\n  \"successRateBySpec\": {";
+    for (unsigned int s = 0; s < numSpecs; ++s) {
+        std::cout << (s ? ", " : " ") << '"' << specs[s].name << "\": "
+                  << (countBySpec[s] ? (double)succeededBySpec[s] / countBySpec[s] : 0);
+    }
+    std::cout << " },\n  \"endError\": { \"p50\": " << percentile(endErrors, 0.5f)
+              << ", \"p90\": " << percentile(endErrors, 0.9f)
+              << ", \"p99\": " << percentile(endErrors, 0.99f)
+              << ", \"max\": " << (endErrors.empty() ? 0 : endErrors.back()) << " },\n";
+    std::cout << "  \"lengthRatio\": { \"p10\": " << percentile(ratios, 0.1f)
+              << ", \"p50\": " << percentile(ratios, 0.5f)
+              << ", \"p90\": " << percentile(ratios, 0.9f)
+              << ", \"p99\": " << percentile(ratios, 0.99f)
+              << ", \"max\": " << (ratios.empty() ? 0 : ratios.back()) << " },\n";
+    std::cout << "  \"lengthRatioHistogram\": [";
+    for (unsigned int b = 0; b < numRatioBuckets; ++b) {
+        std::cout << (b ? ", " : " ") << "{ \"below\": ";
+        if (std::isinf(ratioBuckets[b]))
+            std::cout << "null";
+        else
+            std::cout << ratioBuckets[b];
+        std::cout << ", \"count\": " << ratioCounts[b] << " }";
+    }
+    typedef TrackSection::ClothoidPairStats PairStats;
+    std::cout << " ],\n  \"clothoidPair\": {\n"
+              << "    \"calls\": " << pairStats.calls << ",\n"
+              << "    \"iterations\": " << pairStats.iterations << ",\n"
+              << "    \"outcomes\": { \"converged\": " << pairStats.outcomes[PairStats::Converged]
+              << ", \"noPair\": " << pairStats.outcomes[PairStats::FailureNoPair]
+              << ", \"stalled\": " << pairStats.outcomes[PairStats::FailureStalled]
+              << ", \"iterations\": " << pairStats.outcomes[PairStats::FailureIterations] << " },\n"
+              << "    \"iterationHistogram\": [";
+    for (unsigned int i = 0; i <= PairStats::maxIterations; ++i)
+        std::cout << (i ? ", " : "") << pairStats.iterationCounts[i];
+    std::cout << "]\n  }\n}" << std::endl;
+
+    for (TrackSection *section: sections)
+        delete section;
+    for (TrackNode *node: nodes)
+        delete node;
+    return finite ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+/*
+ * Node frame benchmark.
+ *
+ * Edits many nodes in random orders and checks the positions, midpoints and
+ * curvatures of their tracks, now cached by the node, against the formulas
+ * TrackNode used to evaluate on every call. Then times reading every track
+ * of every node both ways, as rendering and interpolation do each frame.
+ * Returns failure if any value differs.
+ *
+ * Usage: nodeframebench [nodes [passes]]
+ */
+
+#include "TrackNode.h"
+#include "TrackSpec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+    // The original TrackNode accessors, recomputing everything on each call
+    Vec3f referencePosition(const TrackNode *node, int trackIndex)
+    {
+        if (trackIndex == 0)
+            return node->getPosition();
+        Vec2f rightVec;
+        sincosf(node->getDirection() - M_PI/2, &rightVec[1], &rightVec[0]);
+        float displacement = node->getTrackOffset(trackIndex);
+        return node->getPosition() + (rightVec * displacement, 0.0f);
+    }
+
+    Vec3f referenceMidpoint(const TrackNode *node, int startTrack, int ofNumTracks)
+    {
+        Vec2f rightVec;
+        sincosf(node->getDirection() - M_PI/2, &rightVec[1], &rightVec[0]);
+        float displacement = node->getMidpointOffset(startTrack, ofNumTracks);
+        return node->getPosition() + (rightVec * displacement, 0.0f);
+    }
+
+    float referenceCurvature(const TrackNode *node, int trackIndex)
+    {
+        if (trackIndex == 0)
+            return node->getCurvature();
+        float displacement = node->getMinSpec().getTrackSpacing() * 2 * trackIndex;
+        return 1.0f / (1.0f / node->getCurvature() + displacement);
+    }
+
+    // Largest difference from the reference formulas over every track
+    float compare(const TrackNode *node)
+    {
+        unsigned int numTracks = node->getNumTracks();
+        float error = 0.0f;
+        for (unsigned int i = 0; i < numTracks; ++i) {
+            error = std::max(error, (node->getPosition(i) - referencePosition(node, i)).mag());
+            error = std::max(error, fabsf(node->getCurvature(i) - referenceCurvature(node, i)));
+            for (unsigned int n = 1; i + n <= numTracks; ++n)
+                error = std::max(error, (node->getMidpoint(i, n) - referenceMidpoint(node, i, n)).mag());
+        }
+        // And just beyond the tracks, which some callers ask for
+        error = std::max(error, (node->getPosition(numTracks) -
+                                 referencePosition(node, numTracks)).mag());
+        error = std::max(error, fabsf(node->getCurvature(numTracks) -
+                                      referenceCurvature(node, numTracks)));
+        return error;
+    }
+
+    template <typename F>
+    double timePerTrack(const std::vector<TrackNode *> &nodes, unsigned int passes, F func)
+    {
+        unsigned long tracks = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int pass = 0; pass < passes; ++pass) {
+            for (const TrackNode *node: nodes) {
+                unsigned int numTracks = node->getNumTracks();
+                for (unsigned int i = 0; i < numTracks; ++i)
+                    func(node, i);
+                tracks += numTracks;
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / tracks;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int numNodes = 100000;
+    unsigned int numPasses = 10;
+    if (argc > 1)
+        numNodes = std::max(1, atoi(argv[1]));
+    if (argc > 2)
+        numPasses = std::max(1, atoi(argv[2]));
+
+    TrackSpec spec;
+    spec.setTrackSpacing(3.0f);
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> positions(-10000, 10000);
+    std::uniform_real_distribution<float> heights(0, 50);
+    std::uniform_real_distribution<float> angles(-M_PI, M_PI);
+    std::uniform_real_distribution<float> curvatures(-0.01f, 0.01f);
+    std::uniform_int_distribution<unsigned int> tracks(1, 4);
+    std::uniform_int_distribution<unsigned int> edits(0, 4);
+
+    // The cached values are calculated the same way, so should match
+    // exactly, but setMidpoint() now rounds differently
+    const float tolerance = 1e-6f;
+    const float roundTripTolerance = 1e-6f;
+    float maxError = 0.0f, maxRoundTrip = 0.0f;
+    unsigned int mismatches = 0;
+    auto check = [&](const TrackNode *node) {
+        float error = compare(node);
+        maxError = std::max(maxError, error);
+        mismatches += !(error <= tolerance);
+    };
+
+    // Build nodes with edits in random orders, so every path that updates
+    // the cached frame is checked
+    std::vector<TrackNode *> nodes(numNodes);
+    for (TrackNode *&node: nodes) {
+        node = new TrackNode(&spec);
+        for (unsigned int e = 0; e < 6; ++e) {
+            switch (edits(rng)) {
+            case 0:
+                node->setPosition(Vec3f(positions(rng), positions(rng), heights(rng)));
+                break;
+            case 1:
+                node->setDirection(angles(rng));
+                break;
+            case 2:
+                // Straight track is common, and divides by zero
+                node->setCurvature(e & 1 ? curvatures(rng) : 0.0f);
+                break;
+            case 3:
+                node->setNumTracks(tracks(rng));
+                break;
+            case 4: {
+                Vec3f midpoint(positions(rng), positions(rng), heights(rng));
+                node->setMidpoint(midpoint);
+                float error = (node->getMidpoint() - midpoint).mag() / (1.0f + midpoint.mag());
+                maxRoundTrip = std::max(maxRoundTrip, error);
+                break;
+            }
+            }
+            check(node);
+        }
+    }
+
+    std::cout << numNodes << " nodes, max difference " << maxError
+              << ", relative midpoint round trip error " << maxRoundTrip;
+    if (mismatches)
+        std::cout << ", " << mismatches << " edits differ from the reference";
+    std::cout << std::endl;
+
+    float sum = 0.0f;
+    double referenceNs = timePerTrack(nodes, numPasses, [&](const TrackNode *node, unsigned int i) {
+        sum += referencePosition(node, i)[0] + referenceCurvature(node, i) +
+               referenceMidpoint(node, 0, node->getNumTracks())[1];
+    });
+    double cachedNs = timePerTrack(nodes, numPasses, [&](const TrackNode *node, unsigned int i) {
+        sum += node->getPosition(i)[0] + node->getCurvature(i) +
+               node->getMidpoint()[1];
+    });
+    // Keeps the reads from being optimised away
+    volatile float sink = sum;
+    (void)sink;
+    std::cout << std::setprecision(3)
+              << "recomputed: " << referenceNs << "ns per track" << std::endl
+              << "cached:     " << cachedNs << "ns per track, speedup "
+              << referenceNs / cachedNs << std::endl;
+
+    for (TrackNode *node: nodes)
+        delete node;
+
+    bool ok = !mismatches && maxRoundTrip <= roundTripTolerance;
+    std::cout << (ok ? "results match" : "results differ") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+/*
+ * Node picking benchmark.
+ *
+ * Scatters many nodes over a large layout and times picking them with mouse
+ * rays through Railway::findClosestNode(), against the linear scan it used
+ * to make over every node. Also checks nearest and radius queries against
+ * brute force, including after moving some of the nodes. Returns failure if
+ * the index gives any different result.
+ *
+ * Usage: nodeindexbench [nodes [queries]]
+ */
+
+#include "Railway.h"
+#include "TrackNode.h"
+#include "TrackSpec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+    // The original Railway::findClosestNode()
+    TrackNode *findClosestLinear(const std::vector<TrackNode *> &nodes,
+                                 const LineUnit3f &line, float range)
+    {
+        TrackNode *best = nullptr;
+        float bestRangeSqr = range * range;
+        for (TrackNode *node: nodes) {
+            Vec3f closest = line * line.closestPoint(node->getMidpoint());
+            float distanceSqr = (closest - node->getMidpoint()).sqr();
+            if (distanceSqr < bestRangeSqr) {
+                best = node;
+                bestRangeSqr = distanceSqr;
+            }
+        }
+        return best;
+    }
+
+    float groundDistanceSqr(const TrackNode *node, const Vec2f &point)
+    {
+        return ((Vec2f)node->getMidpoint() - point).sqr();
+    }
+
+    template <typename F>
+    double timePerQuery(unsigned int queries, F func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < queries; ++i)
+            func(i);
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::micro>(end - start).count() / queries;
+    }
+
+    // Rays from a camera above the layout to points near nodes
+    std::vector<LineUnit3f> makeRays(const std::vector<TrackNode *> &nodes,
+                                     unsigned int count, std::mt19937 &rng)
+    {
+        std::uniform_int_distribution<size_t> nodeIndices(0, nodes.size() - 1);
+        std::uniform_real_distribution<float> offsets(-3, 3);
+        std::uniform_real_distribution<float> cameraOffsets(-300, 300);
+        std::uniform_real_distribution<float> heights(50, 400);
+        std::vector<LineUnit3f> rays(count);
+        for (LineUnit3f &ray: rays) {
+            Vec3f target = nodes[nodeIndices(rng)]->getMidpoint();
+            target += Vec3f(offsets(rng), offsets(rng), 0.0f);
+            ray.start = target + Vec3f(cameraOffsets(rng), cameraOffsets(rng), heights(rng));
+            ray.norm = target - ray.start;
+            ray.norm /= ray.norm.mag();
+        }
+        return rays;
+    }
+
+    // Check picking, nearest and radius queries against brute force
+    bool check(const Railway &railway, const std::vector<TrackNode *> &nodes,
+               const std::vector<LineUnit3f> &rays, float range, std::mt19937 &rng)
+    {
+        unsigned int mismatches = 0;
+        for (const LineUnit3f &ray: rays) {
+            if (const_cast<Railway &>(railway).findClosestNode(ray, range) !=
+                    findClosestLinear(nodes, ray, range))
+                ++mismatches;
+        }
+
+        constexpr unsigned int k = 8;
+        constexpr float radius = 150;
+        std::uniform_int_distribution<size_t> nodeIndices(0, nodes.size() - 1);
+        std::vector<TrackNode *> found, expected(nodes);
+        for (unsigned int i = 0; i < rays.size() / 10; ++i) {
+            Vec2f point = (Vec2f)nodes[nodeIndices(rng)]->getMidpoint() + Vec2f(10.0f, -20.0f);
+            auto nearer = [&](const TrackNode *a, const TrackNode *b) {
+                return groundDistanceSqr(a, point) < groundDistanceSqr(b, point);
+            };
+
+            railway.findNearestNodes(point, k, &found);
+            std::partial_sort(expected.begin(), expected.begin() + k, expected.end(), nearer);
+            if (found.size() != k ||
+                    !std::equal(found.begin(), found.end(), expected.begin()))
+                ++mismatches;
+
+            railway.findNodesWithinRadius(point, radius, &found);
+            unsigned int within = std::count_if(nodes.begin(), nodes.end(), [&](const TrackNode *node) {
+                return groundDistanceSqr(node, point) <= radius * radius;
+            });
+            bool allWithin = std::all_of(found.begin(), found.end(), [&](const TrackNode *node) {
+                return groundDistanceSqr(node, point) <= radius * radius;
+            });
+            if (found.size() != within || !allWithin)
+                ++mismatches;
+        }
+
+        if (mismatches)
+            std::cout << mismatches << " queries differ from brute force" << std::endl;
+        return !mismatches;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int numNodes = 100000;
+    unsigned int numQueries = 500;
+    if (argc > 1)
+        numNodes = std::max(1, atoi(argv[1]));
+    if (argc > 2)
+        numQueries = std::max(10, atoi(argv[2]));
+
+    TrackSpec spec;
+    spec.setTrackSpacing(3.0f);
+
+    // Nodes scattered over a layout about 20km across, on gentle hills
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> positions(-10000, 10000);
+    std::uniform_real_distribution<float> heights(0, 50);
+    std::uniform_real_distribution<float> angles(-M_PI, M_PI);
+    std::uniform_int_distribution<unsigned int> tracks(1, 4);
+    Railway railway;
+    std::vector<TrackNode *> nodes(numNodes);
+    for (TrackNode *&node: nodes) {
+        node = new TrackNode(&spec);
+        node->setNumTracks(tracks(rng));
+        node->setDirection(angles(rng));
+        node->setMidpoint(Vec3f(positions(rng), positions(rng), heights(rng)));
+        railway.addNode(node);
+    }
+
+    // About the range TrackMode picks with at a typical zoom
+    const float range = 4.0f;
+    std::vector<LineUnit3f> rays = makeRays(nodes, numQueries, rng);
+
+    unsigned int hits = 0;
+    double linearUs = timePerQuery(numQueries, [&](unsigned int i) {
+        hits += findClosestLinear(nodes, rays[i], range) != nullptr;
+    });
+    double indexUs = timePerQuery(numQueries, [&](unsigned int i) {
+        railway.findClosestNode(rays[i], range);
+    });
+    std::cout << numNodes << " nodes, " << numQueries << " picks ("
+              << hits << " hits)" << std::endl
+              << std::setprecision(3)
+              << "linear scan: " << linearUs << "us per pick" << std::endl
+              << "node index:  " << indexUs << "us per pick, speedup "
+              << linearUs / indexUs << std::endl;
+
+    bool ok = check(railway, nodes, rays, range, rng);
+
+    // Drag some nodes around, and change the width of others
+    std::uniform_real_distribution<float> moves(-200, 200);
+    for (unsigned int i = 0; i < numNodes; i += 50) {
+        nodes[i]->setMidpoint(nodes[i]->getMidpoint() + Vec3f(moves(rng), moves(rng), 0.0f));
+        nodes[i + 25 < numNodes ? i + 25 : i]->setNumTracks(tracks(rng));
+    }
+    rays = makeRays(nodes, numQueries, rng);
+    ok = check(railway, nodes, rays, range, rng) && ok;
+
+    std::cout << (ok ? "results match" : "results differ") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,281 @@
+/*
+ * Track node memory benchmark.
+ *
+ * Creates many nodes with typical numbers of tracks and sections attached,
+ * and reports the memory used per node, counting the node itself and its
+ * heap allocations, along with the time taken to create the nodes and to
+ * look up the sections leading off each of them. Does the same for a copy
+ * of the old node layout, with its track info and sections on the heap, to
+ * compare against. Sections are only stored by nodes, never dereferenced,
+ * so placeholders stand in for them.
+ *
+ * Usage: nodememorybench [nodes]
+ */
+
+#include "TrackNode.h"
+#include "TrackSpec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+    // Heap use of everything allocated with new
+    size_t heapBytes = 0;
+    size_t heapAllocations = 0;
+
+    // Space before each allocation recording its size
+    constexpr size_t headerSize = alignof(std::max_align_t);
+}
+
+void *operator new(size_t size)
+{
+    char *block = static_cast<char *>(malloc(size + headerSize));
+    if (!block)
+        throw std::bad_alloc();
+    *reinterpret_cast<size_t *>(block) = size;
+    heapBytes += size;
+    ++heapAllocations;
+    return block + headerSize;
+}
+
+// Not inlined into delete expressions, where GCC would see free() called on
+// a pointer from new, offset before the start of the object
+__attribute__((noinline)) void operator delete(void *ptr) noexcept
+{
+    if (!ptr)
+        return;
+    char *block = static_cast<char *>(ptr) - headerSize;
+    heapBytes -= *reinterpret_cast<size_t *>(block);
+    --heapAllocations;
+    free(block);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+namespace {
+    /*
+     * The node layout before track info and sections were stored inline: a
+     * heap array of track info and a hash set of sections, with the same
+     * scalar members as TrackNode had then.
+     */
+    class OldTrackNode
+    {
+    private:
+        static constexpr unsigned int maxDivergence = 2;
+
+        struct SectionRef {
+            TrackSection *section = nullptr;
+            bool forward = true;
+        };
+
+        struct TrackDirectionInfo {
+            SectionRef sections[maxDivergence];
+            unsigned char numSections = 0;
+            unsigned char defaultIndex = 0;
+
+            bool hasSpaceForSection(const TrackSection *section) const
+            {
+                if (numSections < maxDivergence)
+                    return true;
+                for (const SectionRef &ref: sections)
+                    if (ref.section == section)
+                        return true;
+                return false;
+            }
+
+            void addSection(TrackSection *section, bool forward)
+            {
+                for (const SectionRef &ref: sections)
+                    if (ref.section == section)
+                        return;
+                sections[numSections].section = section;
+                sections[numSections++].forward = forward;
+            }
+        };
+
+        struct TrackInfo {
+            TrackDirectionInfo directionInfo[2];
+        };
+
+        Vec3f position;
+        float direction;
+        float curvature;
+        unsigned int numTracks;
+        const TrackSpec *minSpec;
+        Railway *railway;
+        NodeId id;
+        TrackInfo *trackInfo;
+        std::unordered_set<TrackSection *> allSections;
+
+    public:
+        explicit OldTrackNode(const TrackSpec *spec)
+        : position(0, 0, 0),
+          direction(0),
+          curvature(0),
+          numTracks(1),
+          minSpec(spec),
+          railway(nullptr),
+          trackInfo(nullptr)
+        {
+        }
+
+        ~OldTrackNode()
+        {
+            delete [] trackInfo;
+        }
+
+        void setNumTracks(unsigned int newNumTracks)
+        {
+            if (numTracks == newNumTracks)
+                return;
+            if (!trackInfo || newNumTracks > numTracks) {
+                TrackInfo *newTrackInfo = new TrackInfo[newNumTracks];
+                if (trackInfo)
+                    std::copy(trackInfo, trackInfo + numTracks, newTrackInfo);
+                delete [] trackInfo;
+                trackInfo = newTrackInfo;
+            }
+            numTracks = newNumTracks;
+        }
+
+        bool addTrackSection(bool forward, int startTrack, int ofNumTracks,
+                             TrackSection *section, bool nextForward)
+        {
+            allSections.insert(section);
+            if (startTrack < 0 || startTrack + ofNumTracks > (int)numTracks)
+                return false;
+            if (!trackInfo)
+                trackInfo = new TrackInfo[numTracks];
+            for (int i = startTrack; i < startTrack + ofNumTracks; ++i)
+                if (!trackInfo[i].directionInfo[forward].hasSpaceForSection(section))
+                    return false;
+            for (int i = startTrack; i < startTrack + ofNumTracks; ++i)
+                trackInfo[i].directionInfo[forward].addSection(section, nextForward);
+            return true;
+        }
+
+        const std::unordered_set<TrackSection *> &getSections() const
+        {
+            return allSections;
+        }
+
+        bool hasPoints(unsigned int trackIndex, bool forward) const
+        {
+            if (!trackInfo || trackIndex >= numTracks)
+                return false;
+            return trackInfo[trackIndex].directionInfo[forward].numSections > 1;
+        }
+    };
+
+    struct Layout {
+        unsigned int numTracks;
+        // Sections leading off each side of every track
+        unsigned int sectionsPerSide;
+    };
+
+    struct Result {
+        double bytes;
+        size_t inlineBytes;
+        double allocations;
+        double createNs;
+        double visitNs;
+    };
+
+    template <typename Node>
+    Result measure(const Layout &layout, unsigned int numNodes, const TrackSpec *spec,
+                   std::vector<char> *sectionPlaceholders)
+    {
+        // Distinct addresses for the sections of each node
+        const unsigned int sectionsPerNode = 2 * layout.sectionsPerSide;
+        sectionPlaceholders->resize(sectionsPerNode);
+        auto section = [&](unsigned int i) {
+            return reinterpret_cast<TrackSection *>(&(*sectionPlaceholders)[i]);
+        };
+
+        std::vector<Node *> nodes(numNodes);
+        size_t startBytes = heapBytes, startAllocations = heapAllocations;
+        auto start = std::chrono::steady_clock::now();
+        for (Node *&node: nodes) {
+            node = new Node(spec);
+            node->setNumTracks(layout.numTracks);
+            for (unsigned int s = 0; s < layout.sectionsPerSide; ++s) {
+                node->addTrackSection(true, 0, layout.numTracks, section(2 * s), true);
+                node->addTrackSection(false, 0, layout.numTracks, section(2 * s + 1), false);
+            }
+        }
+        auto created = std::chrono::steady_clock::now();
+        size_t bytes = heapBytes - startBytes;
+        size_t allocations = heapAllocations - startAllocations;
+
+        // Visit the sections of every node, as when notifying them of moves
+        // and following tracks
+        unsigned long found = 0;
+        for (const Node *node: nodes) {
+            for (TrackSection *nodeSection: node->getSections())
+                found += nodeSection != nullptr;
+            for (unsigned int t = 0; t < layout.numTracks; ++t)
+                found += node->hasPoints(t, true);
+        }
+        auto visited = std::chrono::steady_clock::now();
+
+        for (Node *node: nodes)
+            delete node;
+        if (!found)
+            std::cout << "no sections found" << std::endl;
+
+        Result result;
+        result.bytes = (double)bytes / numNodes;
+        result.inlineBytes = sizeof(Node);
+        result.allocations = (double)allocations / numNodes;
+        result.createNs = std::chrono::duration<double, std::nano>(created - start).count() / numNodes;
+        result.visitNs = std::chrono::duration<double, std::nano>(visited - created).count() / numNodes;
+        return result;
+    }
+
+    void print(const char *name, const Result &result)
+    {
+        std::cout << "  " << name << ": " << std::setprecision(4)
+                  << std::setw(6) << result.bytes << " bytes per node ("
+                  << result.inlineBytes << " inline), "
+                  << std::setw(4) << result.allocations << " allocations per node, "
+                  << std::setw(6) << result.createNs << "ns to create, "
+                  << std::setw(6) << result.visitNs << "ns to visit sections" << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int numNodes = 1000000;
+    if (argc > 1)
+        numNodes = std::max(1, atoi(argv[1]));
+
+    TrackSpec spec;
+    spec.setTrackSpacing(3.0f);
+
+    std::cout << numNodes << " nodes" << std::endl;
+    // Plain track, junctions, and wider junctions
+    const Layout layouts[] = {
+        { 1, 1 },
+        { 2, 1 },
+        { 1, 2 },
+        { 2, 2 },
+        { 4, 2 },
+    };
+    std::vector<char> sectionPlaceholders;
+    for (const Layout &layout: layouts) {
+        std::cout << layout.numTracks << " tracks, " << 2 * layout.sectionsPerSide
+                  << " sections:" << std::endl;
+        print("old", measure<OldTrackNode>(layout, numNodes, &spec, &sectionPlaceholders));
+        print("new", measure<TrackNode>(layout, numNodes, &spec, &sectionPlaceholders));
+    }
+    return 0;
+}
@@ -0,0 +1,276 @@
+/*
+ * Railway interpolation benchmark.
+ *
+ * Builds a long meandering line of track sections and times re-interpolating
+ * all of them with Railway::interpolateAll() on increasing numbers of
+ * threads. Returns failure if any thread count changes the resulting track.
+ * Then moves the whole network rigidly, checking that nearly every shape is
+ * reused from the interpolation cache, more quickly than solving afresh,
+ * and that this changes no more sections than solving afresh does.
+ * Finally drafts sections by dragging nodes, checking they are refined when
+ * the drag ends or is held still, and that sections cut short by the time
+ * budget are refined by the next pass without changes.
+ */
+
+#include "Railway.h"
+#include "TrackNode.h"
+#include "TrackSection.h"
+#include "TrackSpec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Lengths and end positions of every section, to compare runs
+    std::vector<float> snapshot(const std::vector<TrackSection *> &sections)
+    {
+        std::vector<float> values;
+        for (const TrackSection *section: sections) {
+            values.push_back(section->getLength(0));
+            Vec3f end = section->getPosition(0, section->getLength(0));
+            values.push_back(end[0]);
+            values.push_back(end[1]);
+        }
+        return values;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // Usage: railwaybench [sections] [max threads]
+    unsigned int numSections = 50000;
+    if (argc > 1)
+        numSections = atoi(argv[1]);
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (argc > 2)
+        maxThreads = std::max(1, atoi(argv[2]));
+
+    Gauge gauge;
+    gauge.setName("standard");
+    gauge.setGauge(1.435f);
+    gauge.addRail(nullptr, Vec2f(-0.7175f, 0));
+    gauge.addRail(nullptr, Vec2f(0.7175f, 0));
+    TrackSpec spec;
+    spec.setName("standard");
+    spec.setTrackGauge(&gauge);
+    spec.setTrackSpacing(3.0f);
+    spec.setMaxCurvature(1.0f / 20.0f);
+    spec.setMinCurvature(1.0f / 30.0f);
+    spec.setMaxCurvatureRate(spec.getMaxCurvature() / 10.0f);
+    spec.setMinCurvatureRate(spec.getMinCurvature() / 10.0f);
+
+    // A random walk of nodes joined by sections
+    Railway railway;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> lengths(30, 120);
+    std::uniform_real_distribution<float> turns(-0.4f, 0.4f);
+    std::uniform_real_distribution<float> curvatures(-1.0f / 60, 1.0f / 60);
+    std::vector<TrackSection *> sections;
+    sections.reserve(numSections);
+    Vec2f position(0, 0);
+    float direction = 0;
+    std::vector<TrackNode *> nodes;
+    TrackNode *last = new TrackNode(&spec);
+    railway.addNode(last);
+    nodes.push_back(last);
+    for (unsigned int i = 0; i < numSections; ++i) {
+        float length = lengths(rng);
+        position += Vec2f(cosf(direction), sinf(direction)) * length;
+        direction += turns(rng);
+        TrackNode *node = new TrackNode(&spec);
+        node->setPosition((Vec3f)position);
+        node->setDirection(direction);
+        node->setCurvature(curvatures(rng));
+        railway.addNode(node);
+        nodes.push_back(node);
+        TrackSection *section = new TrackSection(last->forward(), node->backward(), &spec);
+        railway.addSection(section);
+        sections.push_back(section);
+        last = node;
+    }
+
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    std::cout << numSections << " sections, " << std::thread::hardware_concurrency()
+              << " hardware threads" << std::endl;
+    std::vector<float> reference;
+    double singleMs = 0;
+    bool ok = true;
+    for (unsigned int threads: threadCounts) {
+        railway.setNumThreads(threads);
+        // Warm up, including creating the threads
+        railway.interpolateAll();
+
+        // Time solving rather than cache lookups
+        constexpr unsigned int repeats = 3;
+        double ms = 0;
+        for (unsigned int r = 0; r < repeats; ++r) {
+            railway.getInterpolationCache().clear();
+            auto start = std::chrono::steady_clock::now();
+            railway.interpolateAll();
+            auto end = std::chrono::steady_clock::now();
+            ms += std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+        }
+
+        std::vector<float> result = snapshot(sections);
+        if (reference.empty()) {
+            reference = result;
+            singleMs = ms;
+        }
+        bool same = (result == reference);
+        ok = ok && same;
+        std::cout << std::setw(3) << threads << " threads: " << std::setprecision(4)
+                  << std::setw(8) << ms << "ms, " << std::setw(6)
+                  << ms * 1e6 / numSections << "ns per section, speedup "
+                  << std::setprecision(3) << singleMs / ms
+                  << (same ? "" : " MISMATCH") << std::endl;
+    }
+
+    const Railway::InterpolationStats &stats = railway.getInterpolationStats();
+    std::cout << "interpolations requested " << stats.requested
+              << ", performed " << stats.performed << std::endl;
+    typedef TrackSection::ClothoidPairStats PairStats;
+    PairStats pairStats = TrackSection::getClothoidPairStats();
+    std::cout << "clothoid pairs: " << pairStats.calls << " calls, "
+              << pairStats.outcomes[PairStats::Converged] << " converged, "
+              << std::setprecision(3) << (double)pairStats.iterations / pairStats.calls
+              << " iterations per call, failures: "
+              << pairStats.outcomes[PairStats::FailureNoPair] << " no pair, "
+              << pairStats.outcomes[PairStats::FailureStalled] << " stalled, "
+              << pairStats.outcomes[PairStats::FailureIterations] << " iterations"
+              << std::endl;
+
+    // Move and rotate everything rigidly, with and without the cache. The
+    // solver isn't exactly invariant to this, so compare how many section
+    // lengths change rather than expecting identical results.
+    std::vector<float> unmoved = snapshot(sections);
+    const float rotation = 0.3f;
+    const Vec2f translation(123.4f, -56.7f);
+    for (TrackNode *node: nodes) {
+        Vec2f pos = (Vec2f)node->getPosition();
+        Vec2f rotated(pos[0] * cosf(rotation) - pos[1] * sinf(rotation),
+                      pos[0] * sinf(rotation) + pos[1] * cosf(rotation));
+        node->setPosition((Vec3f)(rotated + translation));
+        node->setDirection(node->getDirection() + rotation);
+    }
+    InterpolationCache::Stats before = railway.getInterpolationCache().getStats();
+    auto start = std::chrono::steady_clock::now();
+    railway.interpolateDirty();
+    auto end = std::chrono::steady_clock::now();
+    double cachedMs = std::chrono::duration<double, std::milli>(end - start).count();
+    InterpolationCache::Stats after = railway.getInterpolationCache().getStats();
+    std::vector<float> cached = snapshot(sections);
+
+    railway.getInterpolationCache().clear();
+    start = std::chrono::steady_clock::now();
+    railway.interpolateAll();
+    end = std::chrono::steady_clock::now();
+    double solvedMs = std::chrono::duration<double, std::milli>(end - start).count();
+    std::vector<float> solved = snapshot(sections);
+    unsigned int cachedChanged = 0, solvedChanged = 0;
+    for (size_t i = 0; i < unmoved.size(); i += 3) {
+        cachedChanged += std::fabs(cached[i] - unmoved[i]) > 0.01f;
+        solvedChanged += std::fabs(solved[i] - unmoved[i]) > 0.01f;
+    }
+
+    // Moving sections rigidly should reuse nearly every shape, and be quicker
+    // than solving them all
+    const double minHitRate = 0.9;
+    unsigned long hits = after.hits - before.hits;
+    unsigned long misses = after.misses - before.misses;
+    double hitRate = (double)hits / std::max(hits + misses, 1ul);
+    std::cout << "rigid move: " << hits << " hits, " << misses << " misses ("
+              << std::setprecision(3) << hitRate * 100 << "%), " << std::setprecision(4)
+              << cachedMs << "ms vs " << solvedMs << "ms solving, lengths changed "
+              << cachedChanged << " vs " << solvedChanged << std::endl;
+    ok = ok && cachedChanged <= solvedChanged && hitRate >= minHitRate && cachedMs < solvedMs;
+
+    // Nudge every node as if dragging them, drafting shapes and then
+    // refining them once the drag ends
+    railway.getInterpolationCache().clear();
+    railway.setInteractive(true);
+    for (TrackNode *node: nodes)
+        node->setMidpoint(node->getMidpoint() + Vec3f(0.5f, 0.25f, 0));
+    start = std::chrono::steady_clock::now();
+    railway.interpolateDirty();
+    end = std::chrono::steady_clock::now();
+    double draftMs = std::chrono::duration<double, std::milli>(end - start).count();
+    unsigned int drafted = 0;
+    for (TrackSection *section: sections)
+        drafted += section->isRough();
+    railway.setInteractive(false);
+    start = std::chrono::steady_clock::now();
+    railway.interpolateDirty();
+    end = std::chrono::steady_clock::now();
+    double refineMs = std::chrono::duration<double, std::milli>(end - start).count();
+    unsigned int rough = 0;
+    for (TrackSection *section: sections)
+        rough += section->isRough();
+
+    // Sections which can be reshaped within a frame at 60Hz on one thread
+    const double frameMs = 1000.0 / 60;
+    double draftUs = draftMs * 1000 / numSections;
+    double refineUs = refineMs * 1000 / numSections;
+    std::cout << "drag: " << drafted << " drafted in " << std::setprecision(4)
+              << draftMs << "ms, refined in " << refineMs << "ms, "
+              << rough << " still rough" << std::endl
+              << "  " << draftUs << "us per draft vs " << refineUs << "us solving, "
+              << (unsigned int)(frameMs * 1000 / draftUs) << " vs "
+              << (unsigned int)(frameMs * 1000 / refineUs)
+              << " sections per " << frameMs << "ms frame per thread" << std::endl;
+    ok = ok && rough == 0;
+
+    auto countRough = [&]() {
+        unsigned int count = 0;
+        for (TrackSection *section: sections)
+            count += section->isRough();
+        return count;
+    };
+    // Every other node, so the shapes of sections between them change
+    const size_t numNudged = std::min<size_t>(2000, nodes.size());
+
+    // Hold a drag still, so drafts should be refined once input settles
+    // without waiting for the drag to end
+    railway.setInteractive(true);
+    for (size_t i = 0; i < numNudged; i += 2)
+        nodes[i]->setMidpoint(nodes[i]->getMidpoint() + Vec3f(0.25f, 0.5f, 0));
+    railway.interpolateDirty();
+    unsigned int held = countRough();
+    unsigned int idlePasses = 0;
+    while (countRough() && idlePasses < 1000) {
+        railway.interpolateDirty();
+        ++idlePasses;
+    }
+    rough = countRough();
+    railway.setInteractive(false);
+    std::cout << "held drag: " << held << " drafted, refined after " << idlePasses
+              << " idle passes, " << rough << " still rough" << std::endl;
+    ok = ok && held > 0 && rough == 0;
+
+    // Cut solving short with a tiny budget, leaving sections rough until
+    // the next pass without changes
+    railway.setInterpolationBudget(1e-7f);
+    railway.getInterpolationCache().clear();
+    for (size_t i = 0; i < numNudged; i += 2)
+        nodes[i]->setMidpoint(nodes[i]->getMidpoint() - Vec3f(0.25f, 0.5f, 0));
+    railway.interpolateDirty();
+    unsigned int cut = countRough();
+    railway.interpolateDirty();
+    rough = countRough();
+    railway.setInterpolationBudget(0);
+    std::cout << "budget: " << cut << " cut short, " << rough
+              << " still rough after the next pass" << std::endl;
+    ok = ok && cut > 0 && rough == 0;
+
+    return ok ? 0 : 1;
+}
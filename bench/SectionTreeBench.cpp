@@ -0,0 +1,319 @@
+/*
+ * Section range query benchmark.
+ *
+ * Lays many meandering lines of track sections over an area growing with
+ * their number, and times box, radius, ray and closest track queries
+ * through Railway's section tree against linear scans of every section.
+ * Then moves some nodes and re-interpolates, timing the refit, and checks
+ * the queries again, and again after deleting some nodes and sections.
+ * Returns failure if the tree gives any different result from the linear
+ * scans, or handles to deleted sections still resolve.
+ *
+ * Usage: sectiontreebench [sections [queries]]
+ */
+
+#include "Gauge.h"
+#include "Railway.h"
+#include "TrackNode.h"
+#include "TrackSection.h"
+#include "TrackSpec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+    typedef std::vector<TrackSection *> Sections;
+
+    struct Query {
+        Vec2f point;
+        Vec2f direction;
+        Box2f box;
+    };
+
+    void scanBox(const Sections &sections, const Box2f &box, Sections *out)
+    {
+        out->clear();
+        for (TrackSection *section: sections)
+            if (section->getBounds().intersects(box))
+                out->push_back(section);
+    }
+
+    void scanRadius(const Sections &sections, const Vec2f &point, float radius, Sections *out)
+    {
+        out->clear();
+        int trackIndex;
+        float distance, separation;
+        for (TrackSection *section: sections) {
+            if (section->getBounds().distanceSqr(point) <= radius * radius &&
+                    section->findClosestPoint(point, &trackIndex, &distance, &separation) &&
+                    separation <= radius)
+                out->push_back(section);
+        }
+    }
+
+    void scanRay(const Sections &sections, const Vec2f &origin, const Vec2f &direction,
+                 float length, Sections *out)
+    {
+        // Clip the ray to each box in turn
+        out->clear();
+        std::vector<std::pair<float, TrackSection *>> hits;
+        for (TrackSection *section: sections) {
+            const Box2f &bounds = section->getBounds();
+            if (bounds.empty())
+                continue;
+            float entry = 0, exit = length;
+            for (int i = 0; i < 2 && entry <= exit; ++i) {
+                float t1 = (bounds.getMin()[i] - origin[i]) / direction[i];
+                float t2 = (bounds.getMax()[i] - origin[i]) / direction[i];
+                entry = std::max(entry, std::min(t1, t2));
+                exit = std::min(exit, std::max(t1, t2));
+            }
+            if (entry <= exit)
+                hits.push_back({entry, section});
+        }
+        std::sort(hits.begin(), hits.end());
+        for (const auto &hit: hits)
+            out->push_back(hit.second);
+    }
+
+    TrackSection *scanClosest(const Sections &sections, const Vec2f &point, float maxSeparation)
+    {
+        TrackSection *best = nullptr;
+        float bestSeparation = maxSeparation;
+        int trackIndex;
+        float distance, separation;
+        for (TrackSection *section: sections) {
+            if (section->findClosestPoint(point, &trackIndex, &distance, &separation) &&
+                    separation < bestSeparation) {
+                best = section;
+                bestSeparation = separation;
+            }
+        }
+        return best;
+    }
+
+    bool sameSet(Sections a, Sections b)
+    {
+        std::sort(a.begin(), a.end());
+        std::sort(b.begin(), b.end());
+        return a == b;
+    }
+
+    template <typename F>
+    double timePerQuery(unsigned int queries, F func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < queries; ++i)
+            func(i);
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::micro>(end - start).count() / queries;
+    }
+
+    constexpr float boxSize = 200;
+    constexpr float radius = 50;
+    constexpr float rayLength = 300;
+    constexpr float maxSeparation = 100;
+
+    // Time each kind of query both ways, returning false on any difference
+    bool measure(const Railway &railway, const Sections &sections,
+                 const std::vector<Query> &queries, unsigned int scanQueries)
+    {
+        Sections found, expected;
+        unsigned int mismatches = 0;
+        int trackIndex;
+        float distance;
+        std::cout << std::setprecision(3);
+
+        double treeUs = timePerQuery(queries.size(), [&](unsigned int i) {
+            railway.findSectionsInBox(queries[i].box, &found);
+        });
+        double scanUs = timePerQuery(scanQueries, [&](unsigned int i) {
+            railway.findSectionsInBox(queries[i].box, &found);
+            scanBox(sections, queries[i].box, &expected);
+            mismatches += !sameSet(found, expected);
+        });
+        std::cout << "box:     " << std::setw(8) << treeUs << "us per query, linear scan "
+                  << std::setw(8) << scanUs << "us" << std::endl;
+
+        treeUs = timePerQuery(queries.size(), [&](unsigned int i) {
+            railway.findSectionsWithinRadius(queries[i].point, radius, &found);
+        });
+        scanUs = timePerQuery(scanQueries, [&](unsigned int i) {
+            railway.findSectionsWithinRadius(queries[i].point, radius, &found);
+            scanRadius(sections, queries[i].point, radius, &expected);
+            mismatches += !sameSet(found, expected);
+        });
+        std::cout << "radius:  " << std::setw(8) << treeUs << "us per query, linear scan "
+                  << std::setw(8) << scanUs << "us" << std::endl;
+
+        treeUs = timePerQuery(queries.size(), [&](unsigned int i) {
+            railway.findSectionsOnRay(queries[i].point, queries[i].direction, rayLength, &found);
+        });
+        scanUs = timePerQuery(scanQueries, [&](unsigned int i) {
+            railway.findSectionsOnRay(queries[i].point, queries[i].direction, rayLength, &found);
+            scanRay(sections, queries[i].point, queries[i].direction, rayLength, &expected);
+            mismatches += found != expected;
+        });
+        std::cout << "ray:     " << std::setw(8) << treeUs << "us per query, linear scan "
+                  << std::setw(8) << scanUs << "us" << std::endl;
+
+        treeUs = timePerQuery(queries.size(), [&](unsigned int i) {
+            railway.findClosestTrack(queries[i].point, maxSeparation, &trackIndex, &distance);
+        });
+        scanUs = timePerQuery(scanQueries, [&](unsigned int i) {
+            TrackSection *closest = railway.findClosestTrack(queries[i].point, maxSeparation,
+                                                             &trackIndex, &distance);
+            mismatches += closest != scanClosest(sections, queries[i].point, maxSeparation);
+        });
+        std::cout << "closest: " << std::setw(8) << treeUs << "us per query, linear scan "
+                  << std::setw(8) << scanUs << "us" << std::endl;
+
+        if (mismatches)
+            std::cout << mismatches << " queries differ from linear scans" << std::endl;
+        return !mismatches;
+    }
+
+    std::vector<Query> makeQueries(unsigned int count, float extent, std::mt19937 &rng)
+    {
+        std::uniform_real_distribution<float> positions(-extent, extent);
+        std::uniform_real_distribution<float> angles(-M_PI, M_PI);
+        std::vector<Query> queries(count);
+        for (Query &query: queries) {
+            query.point = Vec2f(positions(rng), positions(rng));
+            float angle = angles(rng);
+            query.direction = Vec2f(cosf(angle), sinf(angle));
+            query.box = Box2f(query.point, query.point + Vec2f(boxSize));
+        }
+        return queries;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int numSections = 100000;
+    unsigned int numQueries = 10000;
+    if (argc > 1)
+        numSections = std::max(1, atoi(argv[1]));
+    if (argc > 2)
+        numQueries = std::max(1, atoi(argv[2]));
+    // Linear scans are slow, so check fewer queries
+    const unsigned int scanQueries = std::min(numQueries, 100u);
+
+    Gauge gauge;
+    gauge.setName("standard");
+    gauge.setGauge(1.435f);
+    gauge.addRail(nullptr, Vec2f(-0.7175f, 0));
+    gauge.addRail(nullptr, Vec2f(0.7175f, 0));
+    TrackSpec spec;
+    spec.setName("standard");
+    spec.setTrackGauge(&gauge);
+    spec.setTrackSpacing(3.0f);
+    spec.setMaxCurvature(1.0f / 20.0f);
+    spec.setMinCurvature(1.0f / 30.0f);
+    spec.setMaxCurvatureRate(spec.getMaxCurvature() / 10.0f);
+    spec.setMinCurvatureRate(spec.getMinCurvature() / 10.0f);
+
+    // Random walks of 100 sections from random starts, keeping about the
+    // same density of track whatever the number of sections
+    constexpr unsigned int sectionsPerLine = 100;
+    const float extent = sqrtf(numSections) * 40;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> positions(-extent, extent);
+    std::uniform_real_distribution<float> angles(-M_PI, M_PI);
+    std::uniform_real_distribution<float> lengths(30, 120);
+    std::uniform_real_distribution<float> turns(-0.4f, 0.4f);
+    std::uniform_real_distribution<float> curvatures(-1.0f / 60, 1.0f / 60);
+    std::uniform_int_distribution<unsigned int> tracks(1, 3);
+    Railway railway;
+    Sections sections;
+    std::vector<SectionId> sectionIds;
+    std::vector<TrackNode *> nodes;
+    std::vector<NodeId> nodeIds;
+    sections.reserve(numSections);
+    auto build = std::chrono::steady_clock::now();
+    TrackNode *last = nullptr;
+    Vec2f position;
+    float direction = 0;
+    unsigned int numTracks = 1;
+    for (unsigned int i = 0; i < numSections; ++i) {
+        if (i % sectionsPerLine == 0) {
+            position = Vec2f(positions(rng), positions(rng));
+            direction = angles(rng);
+            numTracks = tracks(rng);
+            last = new TrackNode(&spec);
+            last->setNumTracks(numTracks);
+            last->setPosition((Vec3f)position);
+            last->setDirection(direction);
+            nodeIds.push_back(railway.addNode(last));
+            nodes.push_back(last);
+        }
+        position += Vec2f(cosf(direction), sinf(direction)) * lengths(rng);
+        direction += turns(rng);
+        TrackNode *node = new TrackNode(&spec);
+        node->setNumTracks(numTracks);
+        node->setPosition((Vec3f)position);
+        node->setDirection(direction);
+        node->setCurvature(curvatures(rng));
+        nodeIds.push_back(railway.addNode(node));
+        nodes.push_back(node);
+        TrackSection *section = new TrackSection(last->forward(), node->backward(), &spec);
+        sectionIds.push_back(railway.addSection(section));
+        sections.push_back(section);
+        last = node;
+    }
+    double buildMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - build).count();
+    std::cout << numSections << " sections over " << std::setprecision(3)
+              << 2 * extent / 1000 << "km square, built in " << buildMs << "ms" << std::endl;
+
+    std::vector<Query> queries = makeQueries(numQueries, extent, rng);
+    bool ok = measure(railway, sections, queries, scanQueries);
+
+    // Nudge some nodes by less than the tree margin and move others further
+    std::uniform_real_distribution<float> nudges(-1, 1);
+    std::uniform_real_distribution<float> moves(-50, 50);
+    for (unsigned int i = 0; i < nodes.size(); i += 20) {
+        Vec3f offset = i % 40 ? Vec3f(nudges(rng), nudges(rng), 0.0f)
+                              : Vec3f(moves(rng), moves(rng), 0.0f);
+        nodes[i]->setPosition(nodes[i]->getPosition() + offset);
+    }
+    auto refit = std::chrono::steady_clock::now();
+    railway.interpolateDirty();
+    double refitMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - refit).count();
+    std::cout << "moved " << nodes.size() / 20 << " nodes, re-interpolated and refitted in "
+              << refitMs << "ms" << std::endl;
+
+    queries = makeQueries(numQueries, extent, rng);
+    ok = measure(railway, sections, queries, scanQueries) && ok;
+
+    // Delete some sections, and some nodes along with their sections
+    for (unsigned int i = 0; i < sectionIds.size(); i += 10)
+        railway.removeSection(sectionIds[i]);
+    for (unsigned int i = 5; i < nodeIds.size(); i += 50)
+        railway.removeNode(nodeIds[i]);
+    sections.clear();
+    unsigned int removed = 0;
+    for (unsigned int i = 0; i < sectionIds.size(); ++i) {
+        if (TrackSection *section = railway.getSection(sectionIds[i]))
+            sections.push_back(section);
+        else
+            ++removed;
+    }
+    std::cout << "deleted " << removed << " sections" << std::endl;
+    if (railway.getSection(sectionIds[0]) || railway.getNode(nodeIds[5])) {
+        std::cout << "handles to deleted objects still resolve" << std::endl;
+        ok = false;
+    }
+    queries = makeQueries(numQueries, extent, rng);
+    ok = measure(railway, sections, queries, scanQueries) && ok;
+
+    std::cout << (ok ? "results match" : "results differ") << std::endl;
+    return ok ? 0 : 1;
+}